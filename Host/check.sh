@@ -0,0 +1,96 @@
+#!/bin/sh
+#
+# Replays synthetic traces and checks the gain controller's report (run by "make check").
+#
+# usage: expect REPLAY "SIGGEN ARGUMENTS" NAME=VALUE...
+#
+
+failures=0
+
+expect()
+{
+	replay=$1
+	trace=$2
+	shift 2
+
+	report=$(./siggen $trace | ./$replay)
+	for condition in "$@"
+	do
+		name=${condition%%=*}
+		value=$(echo "$report" | sed -n "s/^$name: //p")
+		if [ "$value" != "${condition#*=}" ]
+		then
+			echo "FAIL: $replay $trace: $name is $value, expected ${condition#*=}"
+			failures=$((failures + 1))
+		fi
+	done
+}
+
+# a steady 10 Hz signal of 25 mV P-P fits gain level 5 (G32): a single increase, no oscillation, with every estimator
+# and with 11-bit samples
+for replay in replay replay-histogram replay-envelope replay-dcblocker replay-mains replay-11bit
+do
+	expect $replay "-t 60 sine:25:10 noise:0.5" gain_changes=1 final_stage=5 reversals=0 saturated_s=0.000
+done
+
+# a detached electrode (flat line) parks the gain at the highest level until it is reattached
+expect replay "-t 30 sine:25:10 noise:0.5 flat:10:20" gain_changes=4 final_stage=5 leadoff_s=10.010
+
+# an electrode that is pinned to a rail parks the gain at the lowest level
+expect replay "-t 30 sine:200:10 noise:0.5 step:2000:10:20" gain_changes=3 final_stage=2 leadoff_s=10.253
+
+# the gain jumps straight to the predicted level: a 10 mV signal goes from G8 to G64 with a single PGA write
+expect replay "-t 20 sine:10:10 noise:0.5" gain_changes=1 pga_writes=1 final_stage=6
+
+# a signal that needs G1 clips at G8: the clip fast attack jumps to G2 (the level for a full-scale amplitude) and
+# the window then goes on to G1, i.e. two PGA writes instead of three single-level steps
+expect replay "-t 20 sine:1000:10 noise:0.5" gain_changes=2 pga_writes=2 final_stage=0
+
+# 4x oversampling (11-bit samples): the gain limits, the clip detection and the rail detection scale with the
+# resolution, so the controller takes the same decisions as with 8-bit samples
+expect replay-11bit "-t 20 sine:10:10 noise:0.5" gain_changes=1 pga_writes=1 final_stage=6
+expect replay-11bit "-t 20 sine:1000:10 noise:0.5" gain_changes=2 pga_writes=2 final_stage=0 ga_clip_decreases=1
+expect replay-11bit "-t 30 sine:200:10 noise:0.5 step:2000:10:20" gain_changes=3 final_stage=2 leadoff_s=10.253
+
+# clip fast attack: wherever the clipping starts within a block, the gain is decreased at most GAINADJUST_CLIP_RUN +
+# ADC_EEG_BLOCK_LENGTH samples (16 ms) after the first saturated sample
+worst=$(for k in $(seq 0 31)
+	do
+		./siggen -t 11 sine:25:10 noise:0.5 step:500:$(awk "BEGIN {print 10 + $k / 2500}"):11 | ./replay | sed -n "s/^max_clip_latency_ms: //p"
+	done | sort -n | tail -n 1)
+if [ "$worst" != "16.0" ]
+then
+	echo "FAIL: clip fast attack: worst-case latency is $worst ms, expected 16.0 ms"
+	failures=$((failures + 1))
+fi
+
+# electrode pop (30 mV, 1 ms time constant) on a G32 signal: the min/max estimator decreases the gain and raises it
+# again a window later, the percentile estimator ignores the pop
+expect replay "-t 30 sine:25:10 noise:0.5 pop:30:10:0.001" gain_changes=3 reversals=2 final_stage=5
+expect replay-histogram "-t 30 sine:25:10 noise:0.5 pop:30:10:0.001" gain_changes=1 reversals=0 final_stage=5
+
+# ga_processBlock() changes the gain at the same samples as ga_newsample() called for every sample (200000 samples
+# with amplitude changes, a pop, a rail offset & a flat line; only the controller's sample count differs, since
+# ga_processBlock() counts the rest of the block after a gain change as well)
+trace="-t 80 sine:25:10 noise:0.5 sine:400:7:20:30 pop:30:40:0.001 step:500:50:55 flat:60:65"
+for replay in replay replay-histogram replay-envelope replay-dcblocker replay-mains replay-11bit
+do
+	if [ "$(./siggen $trace | ./$replay -v | grep -v '^ga_samples:')" != "$(./siggen $trace | ./$replay -v -1 | grep -v '^ga_samples:')" ]
+	then
+		echo "FAIL: $replay: ga_processBlock() and ga_newsample() differ"
+		failures=$((failures + 1))
+	fi
+done
+
+# electrode drift (10 Hz signal with 0.15 Hz wander and a 7 s sawtooth): the drift makes the min/max estimator
+# oscillate between G32 and G64, the DC blocker removes it
+trace="-t 60 sine:12.9:10 sine:12.9:0.15 ramp:2.58:7 noise:0.2"
+expect replay "$trace" gain_changes=36 reversals=35
+expect replay-dcblocker "$trace" gain_changes=1 reversals=0 final_stage=6
+
+if [ $failures -ne 0 ]
+then
+	echo "$failures check(s) failed"
+	exit 1
+fi
+echo "all checks passed"
@@ -0,0 +1,245 @@
+/**
+ * \file		dsp_check.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Checks the fixed-point primitives of dsp.h on the host.
+ *
+ * \details		The host build uses the C code of dsp.h. The inline assembly that is used on devices with a hardware
+ *				multiplier is checked by executing its instruction sequence on a small emulation of the AVR
+ *				instructions involved (FMUL, FMULS, FMULSU, MOVW, ADD, ADC, SBC, CLR) and comparing the result with the
+ *				C code for all edge cases and 4 million pseudo-random operands. The sequences below must be kept in
+ *				step with dsp_fmulQ7() & dsp_fmulQ15(). In addition, the saturation of the additions &
+ *				multiplications and the DC gain of the biquad & moving average are checked.
+ *
+ *				The program returns EXIT_FAILURE if a check fails.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// standard C headers
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// application headers
+#include "globals.h"
+#include "dsp.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Constants
+//----------------------------------------------------------------------------------------------------------
+// registers to which the operands are assigned (FMUL* operands must be in r16 - r23)
+#define R_A			16		///< a (2 bytes)
+#define R_B			18		///< b (2 bytes)
+#define R_P			24		///< product (4 bytes)
+#define R_Z			28		///< zero register of dsp_fmulQ15()
+#define R_ZERO		1		///< __zero_reg__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+static uint8_t			m_uintR[32];							///< register file
+static uint8_t			m_uintC;								///< carry flag
+static uint32_t			m_uintFailures;							///< number of failed checks
+static uint32_t			m_uintSeed = 1;							///< state of the operand generator
+
+//----------------------------------------------------------------------------------------------------------
+//   								AVR Instructions
+//----------------------------------------------------------------------------------------------------------
+static void avr_product(const int32_t intProduct)
+{
+	uint16_t uintShifted = (uint16_t) ((uint32_t) intProduct << 1);
+
+	// C is bit 15 of the unshifted product, r1:r0 holds the product shifted left by one
+	m_uintC = (uint8_t) ((intProduct >> 15) & 1);
+	m_uintR[0] = (uint8_t) uintShifted;
+	m_uintR[1] = (uint8_t) (uintShifted >> 8);
+}
+
+static void fmul(const uint8_t d, const uint8_t r)		{ avr_product((int32_t) m_uintR[d] * m_uintR[r]); }
+static void fmuls(const uint8_t d, const uint8_t r)		{ avr_product((int32_t) (int8_t) m_uintR[d] * (int8_t) m_uintR[r]); }
+static void fmulsu(const uint8_t d, const uint8_t r)	{ avr_product((int32_t) (int8_t) m_uintR[d] * m_uintR[r]); }
+static void movw(const uint8_t d, const uint8_t r)		{ m_uintR[d] = m_uintR[r]; m_uintR[d + 1] = m_uintR[r + 1]; }
+static void clr(const uint8_t d)						{ m_uintR[d] = 0; }
+
+static void add(const uint8_t d, const uint8_t r)
+{
+	uint16_t uintSum = (uint16_t) (m_uintR[d] + m_uintR[r]);
+
+	m_uintR[d] = (uint8_t) uintSum;
+	m_uintC = (uint8_t) (uintSum >> 8);
+}
+
+static void adc(const uint8_t d, const uint8_t r)
+{
+	uint16_t uintSum = (uint16_t) (m_uintR[d] + m_uintR[r] + m_uintC);
+
+	m_uintR[d] = (uint8_t) uintSum;
+	m_uintC = (uint8_t) (uintSum >> 8);
+}
+
+static void sbc(const uint8_t d, const uint8_t r)
+{
+	int16_t intDifference = (int16_t) (m_uintR[d] - m_uintR[r] - m_uintC);
+
+	m_uintR[d] = (uint8_t) intDifference;
+	m_uintC = (uint8_t) (intDifference < 0);
+}
+
+//----------------------------------------------------------------------------------------------------------
+//   								Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Executes the instruction sequence of dsp_fmulQ7() (without the -1 * -1 case).
+ */
+static int16_t emu_fmulQ7(const int8_t a, const int8_t b)
+{
+	m_uintR[R_A] = (uint8_t) a;
+	m_uintR[R_B] = (uint8_t) b;
+
+	fmuls(R_A, R_B);
+	movw(R_P, 0);
+	clr(R_ZERO);
+
+	return (int16_t) (m_uintR[R_P] | (m_uintR[R_P + 1] << 8));
+}
+
+/**
+ * \brief		Executes the instruction sequence of dsp_fmulQ15() (without the -1 * -1 case).
+ */
+static int32_t emu_fmulQ15(const int16_t a, const int16_t b)
+{
+	m_uintR[R_A] = (uint8_t) a;
+	m_uintR[R_A + 1] = (uint8_t) ((uint16_t) a >> 8);
+	m_uintR[R_B] = (uint8_t) b;
+	m_uintR[R_B + 1] = (uint8_t) ((uint16_t) b >> 8);
+
+	clr(R_Z);
+	fmuls(R_A + 1, R_B + 1);
+	movw(R_P + 2, 0);
+	fmul(R_A, R_B);
+	adc(R_P + 2, R_Z);
+	movw(R_P, 0);
+	fmulsu(R_A + 1, R_B);
+	sbc(R_P + 3, R_Z);
+	add(R_P + 1, 0);
+	adc(R_P + 2, 1);
+	adc(R_P + 3, R_Z);
+	fmulsu(R_B + 1, R_A);
+	sbc(R_P + 3, R_Z);
+	add(R_P + 1, 0);
+	adc(R_P + 2, 1);
+	adc(R_P + 3, R_Z);
+	clr(R_ZERO);
+
+	return (int32_t) ((uint32_t) m_uintR[R_P] | ((uint32_t) m_uintR[R_P + 1] << 8) |
+					  ((uint32_t) m_uintR[R_P + 2] << 16) | ((uint32_t) m_uintR[R_P + 3] << 24));
+}
+
+/**
+ * \brief		Returns a pseudo-random 16-bit operand (xorshift generator, independent of the C library).
+ */
+static int16_t chk_operand(void)
+{
+	m_uintSeed ^= m_uintSeed << 13;
+	m_uintSeed ^= m_uintSeed >> 17;
+	m_uintSeed ^= m_uintSeed << 5;
+
+	return (int16_t) (m_uintSeed >> 8);
+}
+
+/**
+ * \brief		Counts & reports a failed check.
+ */
+static void chk_expect(const BOOL blnPassed, const char * strCheck, const long intValue)
+{
+	if(!blnPassed)
+	{
+		if(m_uintFailures++ < 10)
+			printf("FAIL: %s (%ld)\n", strCheck, intValue);
+	}
+}
+
+int main(void)
+{
+	static const int16_t intEdges[] = {INT16_MIN, INT16_MIN + 1, -256, -255, -129, -128, -127, -1, 0, 1, 127, 128, 255, 256, INT16_MAX - 1, INT16_MAX};
+	struct DSP_BIQUAD_COEFS coefs = {DSP_Q14(0.013359), DSP_Q14(0.026718), DSP_Q14(0.013359), DSP_Q14(-1.647459), DSP_Q14(0.700896)};
+	struct DSP_BIQUAD biquad = {0};
+	int16_t intHistory[8] = {0};
+	int32_t intSum = 0;
+	int16_t a, b, intOutput = 0;
+	uint32_t i, j;
+
+	// Q7 multiplication: all operands
+	for(i = 0; i < 256; i++)
+	{
+		for(j = 0; j < 256; j++)
+		{
+			if((i == 128) && (j == 128))
+				continue;
+			chk_expect(emu_fmulQ7((int8_t) i, (int8_t) j) == dsp_fmulQ7((int8_t) i, (int8_t) j), "FMULS sequence of dsp_fmulQ7()", (long) ((i << 8) | j));
+		}
+	}
+
+	// Q15 multiplication: edge cases & pseudo-random operands
+	for(i = 0; i < sizeof(intEdges) / sizeof(intEdges[0]); i++)
+	{
+		for(j = 0; j < sizeof(intEdges) / sizeof(intEdges[0]); j++)
+		{
+			if((intEdges[i] == INT16_MIN) && (intEdges[j] == INT16_MIN))
+				continue;
+			chk_expect(emu_fmulQ15(intEdges[i], intEdges[j]) == dsp_fmulQ15(intEdges[i], intEdges[j]), "AVR201 sequence of dsp_fmulQ15()", (long) intEdges[i] * intEdges[j]);
+		}
+	}
+	for(i = 0; i < 4000000UL; i++)
+	{
+		a = chk_operand();
+		b = chk_operand();
+		if((a == INT16_MIN) && (b == INT16_MIN))
+			continue;
+		chk_expect(emu_fmulQ15(a, b) == dsp_fmulQ15(a, b), "AVR201 sequence of dsp_fmulQ15()", (long) i);
+	}
+
+	// saturation
+	chk_expect(dsp_addQ7(100, 100) == INT8_MAX, "dsp_addQ7() positive saturation", dsp_addQ7(100, 100));
+	chk_expect(dsp_addQ7(-100, -100) == INT8_MIN, "dsp_addQ7() negative saturation", dsp_addQ7(-100, -100));
+	chk_expect(dsp_addQ15(30000, 5000) == INT16_MAX, "dsp_addQ15() positive saturation", dsp_addQ15(30000, 5000));
+	chk_expect(dsp_addQ15(-30000, -5000) == INT16_MIN, "dsp_addQ15() negative saturation", dsp_addQ15(-30000, -5000));
+	chk_expect(dsp_addQ31(INT32_MAX - 5, 10) == INT32_MAX, "dsp_addQ31() positive saturation", (long) dsp_addQ31(INT32_MAX - 5, 10));
+	chk_expect(dsp_addQ31(INT32_MIN + 5, -10) == INT32_MIN, "dsp_addQ31() negative saturation", (long) dsp_addQ31(INT32_MIN + 5, -10));
+	chk_expect(dsp_fmulQ7(INT8_MIN, INT8_MIN) == INT16_MAX, "dsp_fmulQ7() -1 * -1", dsp_fmulQ7(INT8_MIN, INT8_MIN));
+	chk_expect(dsp_fmulQ15(INT16_MIN, INT16_MIN) == INT32_MAX, "dsp_fmulQ15() -1 * -1", (long) dsp_fmulQ15(INT16_MIN, INT16_MIN));
+	chk_expect(dsp_macQ15(INT32_MAX - 5, 100, 100) == INT32_MAX, "dsp_macQ15() saturation", (long) dsp_macQ15(INT32_MAX - 5, 100, 100));
+
+	// 2nd-order low-pass (fc = 100 Hz at 2500 Hz, Q = 0.707): unity DC gain (within the Q14 quantization of the
+	// coefficients), no wrap-around at full scale
+	for(i = 0; i < 500; i++)
+		intOutput = dsp_biquad(&biquad, &coefs, 10000);
+	chk_expect((intOutput >= 9950) && (intOutput <= 10050), "dsp_biquad() DC gain", intOutput);
+	for(i = 0; i < 500; i++)
+		intOutput = dsp_biquad(&biquad, &coefs, INT16_MAX);
+	chk_expect(intOutput >= INT16_MAX - 10, "dsp_biquad() full scale", intOutput);
+
+	// moving average over 8 samples of a ramp: mean of the last 8 values
+	for(i = 0; i < 20; i++)
+	{
+		intOutput = dsp_movingAverage(&intSum, (int16_t) i, intHistory[i & 7], 3);
+		intHistory[i & 7] = (int16_t) i;
+	}
+	chk_expect(intOutput == 15, "dsp_movingAverage() of 12 ... 19", intOutput);
+
+	// first-order steps
+	chk_expect(dsp_trackU16(100, 200, 1, 6) == 150, "dsp_trackU16() rise", dsp_trackU16(100, 200, 1, 6));
+	chk_expect(dsp_trackU16(200, 100, 1, 6) == 199, "dsp_trackU16() fall", dsp_trackU16(200, 100, 1, 6));
+
+	if(m_uintFailures)
+	{
+		printf("%lu dsp check(s) failed\n", (unsigned long) m_uintFailures);
+		return EXIT_FAILURE;
+	}
+	printf("dsp checks passed\n");
+
+	return EXIT_SUCCESS;
+}
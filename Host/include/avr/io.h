@@ -0,0 +1,32 @@
+/**
+ * \file		io.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Host stand-in for the AVR-LibC header <avr/io.h>.
+ *
+ * \details		Only the registers that are touched by the modules of the host build are declared. They are plain
+ *				variables (defined in hw_stubs.c), so writes to them have no effect.
+ */
+
+#ifndef __HOST_AVR_IO_H__
+#define __HOST_AVR_IO_H__
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------------------------------
+//   								Registers
+//----------------------------------------------------------------------------------------------------------
+extern volatile uint8_t PORTC;
+
+//----------------------------------------------------------------------------------------------------------
+//   								Bits
+//----------------------------------------------------------------------------------------------------------
+#define PC1		1
+
+//----------------------------------------------------------------------------------------------------------
+//   								Macros
+//----------------------------------------------------------------------------------------------------------
+#define _BV(bit)	(1U << (bit))
+
+#endif
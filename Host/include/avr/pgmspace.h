@@ -0,0 +1,18 @@
+/**
+ * \file		pgmspace.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Host stand-in for the AVR-LibC header <avr/pgmspace.h>: program memory is ordinary memory on the host.
+ */
+
+#ifndef __HOST_AVR_PGMSPACE_H__
+#define __HOST_AVR_PGMSPACE_H__
+
+#include <avr/io.h>
+
+#define PROGMEM
+#define pgm_read_byte(address)	(*(const uint8_t *) (address))
+#define pgm_read_word(address)	(*(const uint16_t *) (address))
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * \file		replay.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Replays an EEG trace through the gain adjustment of the Recording state and reports the behaviour of
+ *				the gain controller.
+ *
+ * \details		The trace is read as text with one sample per line, in mV at the input of the PGA112, sampled at
+ *				\a TMR1_SAMPLING_RATE_HZ (lines starting with '#' are ignored). Every sample is amplified with the
+ *				PGA gain that is in effect at that moment, shifted to mid-scale and quantized to \a ADC_EEG_RESOLUTION
+ *				bits with saturation at the rails (by \a ADC_OVERSAMPLING 10-bit conversions if oversampling is
+ *				enabled), so the controller runs in its own closed loop. A gain change that
+ *				is queued with pga112_queueGain() takes effect after the next conversion, as in the ADC ISR.\n
+ *				The samples are handed over in blocks of \a ADC_EEG_BLOCK_LENGTH samples, and each block is processed
+ *				as in the Recording state of main.c: electrode contact check, gain adjustment, and after a gain change
+ *				the samples that were acquired with the previous gain are skipped. Display Scale episodes are not
+ *				modelled, i.e. the recording continues without a pause after a gain change.
+ *
+ *				usage: replay [-v] [-1] [trace file]\n
+ *				-v	lists every gain change & electrode contact change\n
+ *				-1	hands the samples to ga_newsample() one at a time instead of to ga_processBlock()\n
+ *				The trace is read from the standard input if no file is given.
+ *
+ *				The report lists one "name: value" pair per line: the number of samples, the gain changes & their
+ *				directions, the reversals of direction (oscillations), the number of PGA writes, the time of the last
+ *				gain change (convergence), the time during which the ADC was saturated, the longest time from the first
+ *				saturated sample at a gain level to the PGA write that decreased the gain, the time during which the
+ *				electrodes were considered detached and the final gain level, followed by the controller's own
+ *				statistics. Cycles per sample can't be measured on the host; use the PC1 toggle of ga_processBlock()
+ *				on the device for that.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// standard C headers
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// application headers
+#include "globals.h"
+#include "drivers/avr_adc.h"
+#include "drivers/avr_timer1.h"
+#include "drivers/pga112.h"
+#include "gain_adjust.h"
+#include "lead_off.h"
+#include "stubs.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Constants
+//----------------------------------------------------------------------------------------------------------
+#if (ADC_OVERSAMPLING > 1)
+#define RP_FULLSCALE			1023L									///< largest result of a conversion (10-bit conversions are accumulated & decimated)
+#define RP_DECIMATION_SHIFT		ADC_DECIMATION_SHIFT					///< number of bits by which the sum of the conversions is shifted right
+#else
+#define RP_FULLSCALE			((1L << ADC_EEG_RESOLUTION) - 1)		///< largest result of a conversion
+#define RP_DECIMATION_SHIFT		0										///< number of bits by which the sum of the conversions is shifted right
+#endif
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+static FILE *			m_pTrace;										///< trace that is replayed
+static double			m_dblPrevious;									///< previous sample of the trace (in mV at the PGA input)
+static uint32_t			m_uintSampleIndex;								///< number of samples acquired so far (see avr_adc_getSampleIndex())
+static uint32_t			m_uintSaturated;								///< number of samples at which the ADC was saturated
+static uint32_t			m_uintSaturationStart;							///< index of the first saturated sample since the last gain change
+static BOOL				m_blnSaturationPending;							///< flag indicating that \a m_uintSaturationStart is valid
+static uint32_t			m_uintMaxClipLatency;							///< longest time from the start of saturation to the gain decrease (in samples)
+static BOOL				m_blnPerSample;									///< flag indicating that the samples are handed to ga_newsample()
+
+//----------------------------------------------------------------------------------------------------------
+//   								Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Reads the next sample of the trace.
+ *
+ * \param[out]	pdblSample		sample (in mV at the PGA input)
+ *
+ * \return		TRUE if a sample was read, FALSE at the end of the trace
+ */
+static BOOL rp_readSample(double * pdblSample)
+{
+	char strLine[128];
+	char * pstrEnd;
+
+	while(fgets(strLine, sizeof(strLine), m_pTrace) != NULL)
+	{
+		if(strLine[0] == '#')
+			continue;
+
+		*pdblSample = strtod(strLine, &pstrEnd);
+		if(pstrEnd != strLine)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * \brief		Amplifies a sample with the current PGA gain and converts it.
+ *
+ * \details		With \a ADC_OVERSAMPLING, the conversions of a sample are spread evenly over the sampling period (the
+ *				input is interpolated linearly from the previous sample), accumulated & decimated as in the ADC ISR.
+ *				The sample counts as saturated if one of its conversions is.
+ *
+ * \param[in]	dblSample		sample (in mV at the PGA input)
+ *
+ * \return		ADC result
+ */
+static EEG_SAMPLE rp_convert(const double dblSample)
+{
+	double dblVoltage;
+	long intCode, intSum = 0;
+	BOOL blnSaturated = FALSE;
+	uint8_t k;
+
+	for(k = 1; k <= ADC_OVERSAMPLING; k++)
+	{
+		dblVoltage = (m_dblPrevious * (ADC_OVERSAMPLING - k) + dblSample * k) / ADC_OVERSAMPLING;
+		dblVoltage = GAINADJUST_VREF_MV / 2.0 + dblVoltage * (double) (1 << stub_pga_getGain());
+		intCode = (long) floor(dblVoltage * (RP_FULLSCALE + 1) / GAINADJUST_VREF_MV);
+		if((intCode <= 0) || (intCode >= RP_FULLSCALE))
+			blnSaturated = TRUE;
+		if(intCode < 0)
+			intCode = 0;
+		else if(intCode > RP_FULLSCALE)
+			intCode = RP_FULLSCALE;
+		intSum += intCode;
+	}
+	m_dblPrevious = dblSample;
+
+	if(blnSaturated)
+	{
+		m_uintSaturated++;
+		if(!m_blnSaturationPending)
+		{
+			m_uintSaturationStart = m_uintSampleIndex;
+			m_blnSaturationPending = TRUE;
+		}
+	}
+
+	return (EEG_SAMPLE) (intSum >> RP_DECIMATION_SHIFT);
+}
+
+/**
+ * \brief		Acquires the next block of samples.
+ *
+ * \param[out]	puintBlock		block of \a ADC_EEG_BLOCK_LENGTH samples
+ *
+ * \return		TRUE if a whole block was acquired, FALSE at the end of the trace
+ */
+static BOOL rp_acquireBlock(EEG_SAMPLE * puintBlock)
+{
+	enum PGA112_GAINS gain;
+	double dblSample;
+	uint8_t i;
+
+	for(i = 0; i < ADC_EEG_BLOCK_LENGTH; i++)
+	{
+		if(!rp_readSample(&dblSample))
+			return FALSE;
+
+		puintBlock[i] = rp_convert(dblSample);
+		m_uintSampleIndex++;
+
+		// the ADC ISR transmits a queued gain right after the conversion
+		gain = stub_pga_getGain();
+		stub_pga_writeQueued();
+		if(stub_pga_getGain() != gain)
+		{
+			// reaction time to saturation
+			if(m_blnSaturationPending && (stub_pga_getGain() < gain) && (m_uintSampleIndex - m_uintSaturationStart > m_uintMaxClipLatency))
+				m_uintMaxClipLatency = m_uintSampleIndex - m_uintSaturationStart;
+			m_blnSaturationPending = FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * \brief		Hands new samples to the gain adjustment, either as a block or one sample at a time.
+ *
+ * \param[in]	puintSamples	new samples
+ * \param[in]	uintCount		number of samples
+ * \param[out]	puintIndex		index of the sample at which the gain level was changed (only valid if TRUE is returned)
+ *
+ * \return		TRUE if the gain level was changed, FALSE otherwise
+ */
+static BOOL rp_adjustGain(const EEG_SAMPLE * puintSamples, const uint8_t uintCount, uint8_t * puintIndex)
+{
+	uint8_t i;
+
+	if(!m_blnPerSample)
+		return ga_processBlock(puintSamples, uintCount, puintIndex);
+
+	// the samples that follow a gain change were acquired with the previous gain
+	for(i = 0; i < uintCount; i++)
+	{
+		if(ga_newsample(puintSamples[i]))
+		{
+			*puintIndex = i;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * \brief		Converts a number of samples into seconds.
+ */
+static double rp_seconds(const uint32_t uintSamples)
+{
+	return (double) uintSamples / TMR1_SAMPLING_RATE_HZ;
+}
+
+int main(int argc, char * argv[])
+{
+	EEG_SAMPLE uintBlock[ADC_EEG_BLOCK_LENGTH];
+	uint32_t uintBlockIndex, uintResumeIndex, uintLastChange, uintLeadOff, uintWrites;
+	uint16_t uintChanges, uintIncreases, uintDecreases, uintReversals;
+	uint8_t uintOffset, uintStage, uintLastDirection, i;
+	BOOL blnVerbose, blnGainChanged;
+	enum LO_STATE loState;
+#ifdef GAINADJUST_STATISTICS
+	struct GA_STATISTICS statistics;
+#endif
+
+	// command line
+	blnVerbose = FALSE;
+	m_pTrace = stdin;
+	for(i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-v") == 0)
+			blnVerbose = TRUE;
+		else if(strcmp(argv[i], "-1") == 0)
+			m_blnPerSample = TRUE;
+		else if((m_pTrace = fopen(argv[i], "r")) == NULL)
+		{
+			perror(argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// power-up & start of the Recording state
+	ga_init();
+	ga_reset();
+	lo_init();
+	uintWrites = stub_pga_getWrites();
+	uintStage = ga_getGainStage();
+	uintResumeIndex = 0;
+	uintLastChange = uintLeadOff = 0;
+	uintChanges = uintIncreases = uintDecreases = uintReversals = 0;
+	uintLastDirection = 0;
+
+	while(rp_acquireBlock(uintBlock))
+	{
+		// skip the samples that were acquired with the previous gain
+		uintBlockIndex = m_uintSampleIndex - ADC_EEG_BLOCK_LENGTH;
+		uintOffset = 0;
+		if((int32_t) (uintResumeIndex - uintBlockIndex) > 0)
+			uintOffset = (uintResumeIndex - uintBlockIndex < ADC_EEG_BLOCK_LENGTH) ? (uint8_t) (uintResumeIndex - uintBlockIndex) : ADC_EEG_BLOCK_LENGTH;
+
+		// check the electrode contact (same as in the Recording state)
+		blnGainChanged = FALSE;
+		i = 0;
+		if(lo_processBlock(uintBlock + uintOffset, ADC_EEG_BLOCK_LENGTH - uintOffset))
+		{
+			loState = lo_getState();
+			if(blnVerbose)
+				printf("%9.3f s: electrode contact state %u\n", rp_seconds(uintBlockIndex + ADC_EEG_BLOCK_LENGTH), (unsigned) loState);
+
+			if(loState == LO_CONTACT)
+				ga_reset();
+			else
+			{
+				i = (uint8_t) (ADC_EEG_BLOCK_LENGTH - 1 - uintOffset);
+				blnGainChanged = ga_setGainStage((loState == LO_FLAT) ? (GAINADJUST_NSTAGES - 1) : 0);
+			}
+		}
+		else if((uintOffset < ADC_EEG_BLOCK_LENGTH) && (lo_getState() == LO_CONTACT))
+			blnGainChanged = rp_adjustGain(uintBlock + uintOffset, ADC_EEG_BLOCK_LENGTH - uintOffset, &i);
+
+		if(lo_getState() != LO_CONTACT)
+			uintLeadOff += ADC_EEG_BLOCK_LENGTH;
+
+		if(blnGainChanged)
+		{
+			uintLastChange = uintBlockIndex + uintOffset + i;
+			if(blnVerbose)
+				printf("%9.3f s: gain level %u -> %u\n", rp_seconds(uintLastChange), (unsigned) uintStage, (unsigned) ga_getGainStage());
+
+			uintChanges++;
+			if(ga_getGainStage() > uintStage)
+			{
+				uintIncreases++;
+				if(uintLastDirection == 2)
+					uintReversals++;
+				uintLastDirection = 1;
+			}
+			else
+			{
+				uintDecreases++;
+				if(uintLastDirection == 1)
+					uintReversals++;
+				uintLastDirection = 2;
+			}
+			uintStage = ga_getGainStage();
+
+			lo_reset();
+
+			// all samples that were acquired so far used the previous gain
+			uintResumeIndex = m_uintSampleIndex;
+		}
+	}
+
+	// report
+	printf("samples: %lu\n", (unsigned long) m_uintSampleIndex);
+	printf("gain_changes: %u\n", (unsigned) uintChanges);
+	printf("increases: %u\n", (unsigned) uintIncreases);
+	printf("decreases: %u\n", (unsigned) uintDecreases);
+	printf("reversals: %u\n", (unsigned) uintReversals);
+	printf("pga_writes: %lu\n", (unsigned long) (stub_pga_getWrites() - uintWrites));
+	printf("last_change_s: %.3f\n", rp_seconds(uintLastChange));
+	printf("saturated_s: %.3f\n", rp_seconds(m_uintSaturated));
+	printf("max_clip_latency_ms: %.1f\n", rp_seconds(m_uintMaxClipLatency) * 1000);
+	printf("leadoff_s: %.3f\n", rp_seconds(uintLeadOff));
+	printf("final_stage: %u\n", (unsigned) ga_getGainStage());
+#ifdef GAINADJUST_STATISTICS
+	ga_getStatistics(&statistics);
+	printf("ga_samples: %lu\n", (unsigned long) statistics.uintSamples);
+	printf("ga_clipped_samples: %lu\n", (unsigned long) statistics.uintClippedSamples);
+	printf("ga_clip_decreases: %u\n", (unsigned) statistics.uintClipDecreases);
+#endif
+
+	if(m_pTrace != stdin)
+		fclose(m_pTrace);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+/**
+ * \file		ring_check.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Checks the ring buffers of ring_buffer.h on the host.
+ *
+ * \details		The buffers are checked at the smallest (2) and the largest (256) length:\n
+ *				- the empty & full boundaries (at most \a length - 1 elements are stored) of every access function\n
+ *				- the wrap-around of put/write and get/read/peek/tail+skip, with pseudo-random block sizes\n
+ *				- a producer thread and a consumer thread that run concurrently (as the ADC ISR and the background
+ *				  loop do), each using all of its access functions; the consumer checks that every element arrives
+ *				  once and in order, that it never sees more elements than were stored and that all of them arrive
+ *
+ *				The program returns EXIT_FAILURE if a check fails.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// standard C headers
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+// application headers
+#include "globals.h"
+#include "ring_buffer.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Constants
+//----------------------------------------------------------------------------------------------------------
+#define CHK_SEQUENTIAL			1000000UL		///< number of operations of the single-threaded wrap-around check
+#define CHK_CONCURRENT			1000000UL		///< number of elements passed from the producer to the consumer thread
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Access functions of a ring buffer (the functions generated by RB_DEFINE() are specific to each buffer).
+ */
+struct CHK_RING {const char *		strName;								///< name of the ring buffer
+				 uint16_t			uintLength;								///< length of the ring buffer
+				 void				(*init)(void);
+				 uint8_t			(*count)(void);
+				 uint8_t			(*free)(void);
+				 BOOL				(*put)(uint32_t value);
+				 uint8_t			(*write)(const uint32_t * pSrc, uint8_t n);
+				 BOOL				(*get)(uint32_t * pValue);
+				 BOOL				(*peek)(uint32_t * pValue);
+				 uint8_t			(*read)(uint32_t * pDst, uint8_t n);
+				 const uint32_t *	(*tail)(void);
+				 void				(*skip)(uint8_t n);
+				 const uint32_t *	puintEnd;								///< end of the ring buffer's array
+				};
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+RB_DEFINE(two, uint32_t, 2)														// smallest ring buffer (a single element)
+RB_DEFINE(big, uint32_t, 256)													// largest ring buffer (255 elements)
+
+static const struct CHK_RING	mc_Rings[] = {{"length 2", 2, rb_two_init, rb_two_count, rb_two_free, rb_two_put, rb_two_write, rb_two_get, rb_two_peek, rb_two_read, rb_two_tail, rb_two_skip, &m_rb_two.data[2]},
+											  {"length 256", 256, rb_big_init, rb_big_count, rb_big_free, rb_big_put, rb_big_write, rb_big_get, rb_big_peek, rb_big_read, rb_big_tail, rb_big_skip, &m_rb_big.data[256]}};	///< ring buffers that are checked
+
+static volatile uint32_t		m_uintFailures;									///< number of failed checks
+static volatile BOOL			m_blnProducerDone;								///< flag indicating that the producer thread has stored all of its elements
+static volatile BOOL			m_blnConsumerDone;								///< flag indicating that the consumer has stopped (ends the producer thread if elements were duplicated)
+static volatile uint32_t		m_uintReserved;									///< upper limit of the number of elements stored by the producer thread so far (raised before each put/write, lowered to the actual number afterwards)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Counts & reports a failed check.
+ */
+static void chk_expect(const BOOL blnPassed, const struct CHK_RING * pRing, const char * strCheck, const long intValue)
+{
+	if(!blnPassed)
+	{
+		if(m_uintFailures++ < 10)
+			printf("FAIL: %s: %s (%ld)\n", pRing->strName, strCheck, intValue);
+	}
+}
+
+/**
+ * \brief		Returns a pseudo-random number (xorshift generator, independent of the C library).
+ */
+static uint32_t chk_random(uint32_t * puintSeed)
+{
+	*puintSeed ^= *puintSeed << 13;
+	*puintSeed ^= *puintSeed >> 17;
+	*puintSeed ^= *puintSeed << 5;
+
+	return *puintSeed;
+}
+
+/**
+ * \brief		Checks the empty & full boundaries.
+ */
+static void chk_boundaries(const struct CHK_RING * pRing)
+{
+	uint32_t uintValues[256], uintValue = 0;
+	uint8_t uintCapacity = (uint8_t) (pRing->uintLength - 1);
+	uint16_t i;
+
+	// empty
+	pRing->init();
+	chk_expect(pRing->count() == 0, pRing, "count of an empty buffer", pRing->count());
+	chk_expect(pRing->free() == uintCapacity, pRing, "free space of an empty buffer", pRing->free());
+	chk_expect(!pRing->get(&uintValue), pRing, "get from an empty buffer", 0);
+	chk_expect(!pRing->peek(&uintValue), pRing, "peek into an empty buffer", 0);
+	chk_expect(pRing->read(uintValues, 1) == 0, pRing, "read from an empty buffer", 0);
+
+	// full after length - 1 elements
+	for(i = 0; i < uintCapacity; i++)
+		chk_expect(pRing->put(i), pRing, "put into a buffer that isn't full", i);
+	chk_expect(!pRing->put(i), pRing, "put into a full buffer", i);
+	chk_expect(pRing->write(uintValues, 1) == 0, pRing, "write into a full buffer", 0);
+	chk_expect(pRing->count() == uintCapacity, pRing, "count of a full buffer", pRing->count());
+	chk_expect(pRing->free() == 0, pRing, "free space of a full buffer", pRing->free());
+
+	// write & read are limited to the free space & the count
+	pRing->skip(1);
+	for(i = 0; i < uintCapacity; i++)
+		uintValues[i] = uintCapacity + i;
+	chk_expect(pRing->write(uintValues, uintCapacity) == 1, pRing, "write of more than the free space", pRing->count());
+	chk_expect(pRing->get(&uintValue) && (uintValue == 1), pRing, "oldest element after skip", (long) uintValue);
+	chk_expect(pRing->read(uintValues, uintCapacity) == uintCapacity - 1, pRing, "read of more than the count", pRing->count());
+	chk_expect((uintCapacity == 1) || (uintValues[uintCapacity - 2] == uintCapacity), pRing, "newest element", (long) uintValues[0]);
+	chk_expect(pRing->count() == 0, pRing, "count after read", pRing->count());
+}
+
+/**
+ * \brief		Checks the wrap-around with a pseudo-random sequence of all access functions.
+ */
+static void chk_wrap(const struct CHK_RING * pRing)
+{
+	uint32_t uintValues[256], uintValue;
+	uint32_t uintSeed = 1, uintNextIn = 0, uintNextOut = 0, uintOperation;
+	uint8_t uintCapacity = (uint8_t) (pRing->uintLength - 1);
+	uint8_t n, m, i;
+
+	pRing->init();
+	for(uintOperation = 0; uintOperation < CHK_SEQUENTIAL; uintOperation++)
+	{
+		n = (uint8_t) (chk_random(&uintSeed) % pRing->uintLength);
+		switch(chk_random(&uintSeed) % 6)
+		{
+			case 0:
+				if(pRing->put(uintNextIn))
+					uintNextIn++;
+				else
+					chk_expect(uintNextIn - uintNextOut == uintCapacity, pRing, "put into a buffer that isn't full", (long) (uintNextIn - uintNextOut));
+			break;
+
+			case 1:
+				for(i = 0; i < n; i++)
+					uintValues[i] = uintNextIn + i;
+				m = pRing->write(uintValues, n);
+				chk_expect(m == ((n < uintCapacity - (uintNextIn - uintNextOut)) ? n : uintCapacity - (uintNextIn - uintNextOut)), pRing, "number of elements written", m);
+				uintNextIn += m;
+			break;
+
+			case 2:
+				if(pRing->get(&uintValue))
+					chk_expect(uintValue == uintNextOut++, pRing, "element order (get)", (long) uintValue);
+				else
+					chk_expect(uintNextIn == uintNextOut, pRing, "get from a buffer that isn't empty", (long) (uintNextIn - uintNextOut));
+			break;
+
+			case 3:
+				m = pRing->read(uintValues, n);
+				chk_expect(m == ((n < uintNextIn - uintNextOut) ? n : uintNextIn - uintNextOut), pRing, "number of elements read", m);
+				for(i = 0; i < m; i++)
+					chk_expect(uintValues[i] == uintNextOut++, pRing, "element order (read)", (long) uintValues[i]);
+			break;
+
+			case 4:
+				if(pRing->peek(&uintValue))
+					chk_expect(uintValue == uintNextOut, pRing, "element order (peek)", (long) uintValue);
+			break;
+
+			default:
+				// tail + skip, limited to the contiguous elements (as for the blocks of avr_adc_getBlock())
+				for(i = 0; (i < n) && (i < uintNextIn - uintNextOut) && (pRing->tail() + i < pRing->puintEnd); i++)
+					chk_expect(pRing->tail()[i] == uintNextOut + i, pRing, "element order (tail)", (long) pRing->tail()[i]);
+				pRing->skip(i);
+				uintNextOut += i;
+			break;
+		}
+		chk_expect(pRing->count() == uintNextIn - uintNextOut, pRing, "count", pRing->count());
+	}
+}
+
+/**
+ * \brief		Producer thread of chk_concurrent(): stores the numbers 0 ... \a CHK_CONCURRENT - 1.
+ */
+static void * chk_producer(void * pArg)
+{
+	const struct CHK_RING * pRing = (const struct CHK_RING *) pArg;
+	uint32_t uintValues[256];
+	uint32_t uintSeed = 3, uintNext = 0;
+	uint8_t n, i;
+
+	while((uintNext < CHK_CONCURRENT) && !m_blnConsumerDone)
+	{
+		// let the consumer run while the buffer is full (the host may have a single CPU)
+		if(pRing->free() == 0)
+			sched_yield();
+
+		if(chk_random(&uintSeed) & 1)
+		{
+			m_uintReserved = uintNext + 1;
+			if(pRing->put(uintNext))
+				uintNext++;
+		}
+		else
+		{
+			n = (uint8_t) (chk_random(&uintSeed) % pRing->uintLength);
+			if(n > CHK_CONCURRENT - uintNext)
+				n = (uint8_t) (CHK_CONCURRENT - uintNext);
+			for(i = 0; i < n; i++)
+				uintValues[i] = uintNext + i;
+			m_uintReserved = uintNext + n;
+			uintNext += pRing->write(uintValues, n);
+		}
+		m_uintReserved = uintNext;
+	}
+	m_blnProducerDone = TRUE;
+
+	return NULL;
+}
+
+/**
+ * \brief		Passes \a CHK_CONCURRENT elements from a producer thread to the calling (consumer) thread.
+ */
+static void chk_concurrent(const struct CHK_RING * pRing)
+{
+	pthread_t producer;
+	uint32_t uintValues[256], uintValue;
+	uint32_t uintSeed = 5, uintNext = 0;
+	uint8_t uintCount, m, i;
+	BOOL blnDone;
+
+	pRing->init();
+	m_uintReserved = 0;
+	m_blnProducerDone = m_blnConsumerDone = FALSE;
+	if(pthread_create(&producer, NULL, chk_producer, (void *) pRing) != 0)
+	{
+		chk_expect(FALSE, pRing, "producer thread", 0);
+		return;
+	}
+
+	while(uintNext < CHK_CONCURRENT)
+	{
+		// the stored elements were all produced (the count is read before the producer's progress); elements
+		// that were lost end the check once the producer is done
+		blnDone = m_blnProducerDone;
+		uintCount = pRing->count();
+		if(blnDone && (uintCount == 0))
+			break;
+		chk_expect(uintNext + uintCount <= m_uintReserved, pRing, "count seen by the consumer", uintCount);
+
+		// let the producer run while the buffer is empty
+		if(uintCount == 0)
+			sched_yield();
+
+		switch(chk_random(&uintSeed) & 3)
+		{
+			case 0:
+				if(pRing->get(&uintValue))
+					chk_expect(uintValue == uintNext++, pRing, "concurrent element order (get)", (long) uintValue);
+			break;
+
+			case 1:
+				m = pRing->read(uintValues, (uint8_t) (chk_random(&uintSeed) % pRing->uintLength));
+				for(i = 0; i < m; i++)
+					chk_expect(uintValues[i] == uintNext++, pRing, "concurrent element order (read)", (long) uintValues[i]);
+			break;
+
+			case 2:
+				if(pRing->peek(&uintValue))
+					chk_expect(uintValue == uintNext, pRing, "concurrent element order (peek)", (long) uintValue);
+			break;
+
+			default:
+				// at least uintCount elements are stored, whatever the producer does in the meantime
+				for(i = 0; (i < uintCount) && (pRing->tail() + i < pRing->puintEnd); i++)
+					chk_expect(pRing->tail()[i] == uintNext + i, pRing, "concurrent element order (tail)", (long) pRing->tail()[i]);
+				pRing->skip(i);
+				uintNext += i;
+			break;
+		}
+	}
+
+	m_blnConsumerDone = TRUE;
+	pthread_join(producer, NULL);
+	chk_expect(uintNext == CHK_CONCURRENT, pRing, "number of elements consumed", (long) uintNext);
+	chk_expect(pRing->count() == 0, pRing, "count after all elements were consumed", pRing->count());
+}
+
+int main(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < sizeof(mc_Rings) / sizeof(mc_Rings[0]); i++)
+	{
+		chk_boundaries(&mc_Rings[i]);
+		chk_wrap(&mc_Rings[i]);
+		chk_concurrent(&mc_Rings[i]);
+	}
+
+	if(m_uintFailures)
+	{
+		printf("%lu ring buffer check(s) failed\n", (unsigned long) m_uintFailures);
+		return EXIT_FAILURE;
+	}
+	printf("ring buffer checks passed\n");
+
+	return EXIT_SUCCESS;
+}
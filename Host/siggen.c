@@ -0,0 +1,264 @@
+/**
+ * \file		siggen.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Generates synthetic EEG traces for replay.c.
+ *
+ * \details		The trace is the sum of the given components, sampled at \a TMR1_SAMPLING_RATE_HZ and written to the
+ *				standard output with one sample per line (in mV at the input of the PGA112). Amplitudes are P-P
+ *				values in mV and times are in seconds; a component without start & stop time lasts for the whole
+ *				trace.
+ *
+ *				usage: siggen [-t duration] [-s seed] component...\n
+ *				sine:PP:HZ[:START[:STOP]]		sine wave\n
+ *				noise:RMS[:START[:STOP]]		gaussian white noise with the given RMS value\n
+ *				ramp:PP:PERIOD[:START[:STOP]]	sawtooth that rises by PP mV during every period (electrode drift)\n
+ *				step:MV:START[:STOP]			offset of MV mV (an electrode pinned to a rail by a large offset)\n
+ *				pop:MV:START:TAU				step of MV mV at START that decays with a time constant of TAU seconds (electrode pop)\n
+ *				flat:START:STOP					no signal at all (detached electrode)
+ *
+ *				The duration defaults to 60 s and the noise seed to 1; the same seed always gives the same trace.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// standard C headers
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// application headers
+#include "globals.h"
+#include "drivers/avr_timer1.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Constants
+//----------------------------------------------------------------------------------------------------------
+#define SG_MAX_COMPONENTS		16		///< largest number of components of a trace
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Component types.
+ */
+enum SG_TYPE {SG_SINE = 0,
+			  SG_NOISE,
+			  SG_RAMP,
+			  SG_STEP,
+			  SG_POP,
+			  SG_FLAT
+			 };
+
+/**
+ * Component of a trace.
+ */
+struct SG_COMPONENT {enum SG_TYPE	type;			///< component type
+					 double			dblParam1;		///< amplitude (in mV)
+					 double			dblParam2;		///< frequency (sine), period (ramp) or time constant (pop)
+					 double			dblStart;		///< start time (in sec)
+					 double			dblStop;		///< stop time (in sec)
+					};
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+static uint32_t			m_uintSeed = 1;				///< state of the noise generator
+
+//----------------------------------------------------------------------------------------------------------
+//   								Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Returns a uniformly distributed random number in the range (0, 1) (xorshift generator, so the traces
+ *				don't depend on the C library).
+ */
+static double sg_uniform(void)
+{
+	m_uintSeed ^= m_uintSeed << 13;
+	m_uintSeed ^= m_uintSeed >> 17;
+	m_uintSeed ^= m_uintSeed << 5;
+
+	return ((double) m_uintSeed + 1.0) / 4294967297.0;
+}
+
+/**
+ * \brief		Returns a normally distributed random number with zero mean and unit variance (Box-Muller).
+ */
+static double sg_gaussian(void)
+{
+	double dblU1 = sg_uniform();
+	double dblU2 = sg_uniform();
+
+	return sqrt(-2.0 * log(dblU1)) * cos(2.0 * M_PI * dblU2);
+}
+
+/**
+ * \brief		Parses a component given on the command line.
+ *
+ * \param[in]	strArg			command line argument
+ * \param[out]	pComponent		parsed component
+ * \param[in]	dblDuration		duration of the trace (in sec)
+ *
+ * \return		TRUE if the argument is a valid component, FALSE otherwise
+ */
+static BOOL sg_parse(const char * strArg, struct SG_COMPONENT * pComponent, const double dblDuration)
+{
+	double dblValues[4];
+	const char * strValues = strchr(strArg, ':');
+	int intCount;
+
+	if(strValues == NULL)
+		return FALSE;
+
+	intCount = sscanf(strValues, ":%lf:%lf:%lf:%lf", &dblValues[0], &dblValues[1], &dblValues[2], &dblValues[3]);
+	pComponent->dblStart = 0;
+	pComponent->dblStop = dblDuration;
+
+	if(strncmp(strArg, "sine:", 5) == 0 || strncmp(strArg, "ramp:", 5) == 0)
+	{
+		if(intCount < 2)
+			return FALSE;
+		pComponent->type = (strArg[0] == 's') ? SG_SINE : SG_RAMP;
+		pComponent->dblParam1 = dblValues[0];
+		pComponent->dblParam2 = dblValues[1];
+		if(intCount > 2)
+			pComponent->dblStart = dblValues[2];
+		if(intCount > 3)
+			pComponent->dblStop = dblValues[3];
+	}
+	else if(strncmp(strArg, "noise:", 6) == 0)
+	{
+		if(intCount < 1)
+			return FALSE;
+		pComponent->type = SG_NOISE;
+		pComponent->dblParam1 = dblValues[0];
+		if(intCount > 1)
+			pComponent->dblStart = dblValues[1];
+		if(intCount > 2)
+			pComponent->dblStop = dblValues[2];
+	}
+	else if(strncmp(strArg, "step:", 5) == 0)
+	{
+		if(intCount < 2)
+			return FALSE;
+		pComponent->type = SG_STEP;
+		pComponent->dblParam1 = dblValues[0];
+		pComponent->dblStart = dblValues[1];
+		if(intCount > 2)
+			pComponent->dblStop = dblValues[2];
+	}
+	else if(strncmp(strArg, "pop:", 4) == 0)
+	{
+		if(intCount < 3)
+			return FALSE;
+		pComponent->type = SG_POP;
+		pComponent->dblParam1 = dblValues[0];
+		pComponent->dblStart = dblValues[1];
+		pComponent->dblParam2 = dblValues[2];
+	}
+	else if(strncmp(strArg, "flat:", 5) == 0)
+	{
+		if(intCount < 2)
+			return FALSE;
+		pComponent->type = SG_FLAT;
+		pComponent->dblStart = dblValues[0];
+		pComponent->dblStop = dblValues[1];
+	}
+	else
+		return FALSE;
+
+	return TRUE;
+}
+
+int main(int argc, char * argv[])
+{
+	struct SG_COMPONENT components[SG_MAX_COMPONENTS];
+	double dblDuration = 60.0;
+	double dblTime, dblSample, dblElapsed, dblNoise;
+	uint32_t uintSamples, n;
+	uint8_t uintComponents = 0;
+	BOOL blnFlat;
+	int i, j;
+
+	// command line (the duration must be known before the components are parsed)
+	for(i = 1; i < argc - 1; i++)
+	{
+		if(strcmp(argv[i], "-t") == 0)
+			dblDuration = atof(argv[i + 1]);
+	}
+
+	for(i = 1; i < argc; i++)
+	{
+		if((strcmp(argv[i], "-t") == 0) && (i < argc - 1))
+			i++;
+		else if((strcmp(argv[i], "-s") == 0) && (i < argc - 1))
+			m_uintSeed = (uint32_t) strtoul(argv[++i], NULL, 0) | 1;
+		else if((uintComponents < SG_MAX_COMPONENTS) && sg_parse(argv[i], &components[uintComponents], dblDuration))
+			uintComponents++;
+		else
+		{
+			fprintf(stderr, "invalid argument: %s\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	uintSamples = (uint32_t) (dblDuration * TMR1_SAMPLING_RATE_HZ);
+	printf("# %lu samples at %u Hz (mV at the PGA input)\n", (unsigned long) uintSamples, (unsigned) TMR1_SAMPLING_RATE_HZ);
+
+	for(n = 0; n < uintSamples; n++)
+	{
+		dblTime = (double) n / TMR1_SAMPLING_RATE_HZ;
+		dblSample = 0;
+		blnFlat = FALSE;
+
+		for(j = 0; j < uintComponents; j++)
+		{
+			// the noise is drawn for every sample, so that a component doesn't shift the noise of the others
+			if(components[j].type == SG_NOISE)
+			{
+				dblNoise = sg_gaussian();
+				if((dblTime >= components[j].dblStart) && (dblTime < components[j].dblStop))
+					dblSample += components[j].dblParam1 * dblNoise;
+				continue;
+			}
+
+			if((dblTime < components[j].dblStart) || (dblTime >= components[j].dblStop))
+				continue;
+
+			dblElapsed = dblTime - components[j].dblStart;
+			switch(components[j].type)
+			{
+				case SG_SINE:
+					dblSample += components[j].dblParam1 / 2 * sin(2.0 * M_PI * components[j].dblParam2 * dblElapsed);
+					break;
+
+				case SG_RAMP:
+					dblSample += components[j].dblParam1 * (fmod(dblElapsed, components[j].dblParam2) / components[j].dblParam2 - 0.5);
+					break;
+
+				case SG_STEP:
+					dblSample += components[j].dblParam1;
+					break;
+
+				case SG_POP:
+					dblSample += components[j].dblParam1 * exp(-dblElapsed / components[j].dblParam2);
+					break;
+
+				case SG_FLAT:
+					blnFlat = TRUE;
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		printf("%.6f\n", blnFlat ? 0.0 : dblSample);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/**
+ * \file		stubs.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Host stand-ins for the PGA112 & alarms drivers and the AVR registers used by the host build.
+ *
+ * \details		The PGA112 stand-in keeps the gain that the replay applies to the trace. A gain queued with
+ *				pga112_queueGain() takes effect when stub_pga_writeQueued() is called, i.e. right after the next
+ *				conversion as in the ADC ISR; pga112_setGain() takes effect immediately. Every write that changes the
+ *				gain is counted. The alarms (LEDs) are ignored, except for a fatal error, which ends the replay.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// standard C headers
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// application headers
+#include "globals.h"
+#include "alarms.h"
+#include "drivers/pga112.h"
+#include "stubs.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+volatile uint8_t			PORTC;								///< PC1 is toggled by ga_processBlock()
+
+static enum PGA112_GAINS	m_Gain;								///< gain that is applied to the trace
+static enum PGA112_GAINS	m_QueuedGain;						///< gain that is applied after the next conversion
+static BOOL					m_blnQueued;						///< flag indicating that \a m_QueuedGain is pending
+static uint32_t				m_uintWrites;						///< number of writes that changed the gain
+
+//----------------------------------------------------------------------------------------------------------
+//   								Functions
+//----------------------------------------------------------------------------------------------------------
+void pga112_init(void)
+{
+	m_blnQueued = FALSE;
+}
+
+void pga112_setChannel(enum PGA112_CHANNELS channel)
+{
+	(void) channel;
+}
+
+void pga112_setGain(enum PGA112_GAINS gain)
+{
+	m_blnQueued = FALSE;
+	if(gain != m_Gain)
+		m_uintWrites++;
+	m_Gain = gain;
+}
+
+void pga112_queueGain(enum PGA112_GAINS gain)
+{
+	m_QueuedGain = gain;
+	m_blnQueued = TRUE;
+}
+
+void alarms_set(enum ALARM_TYPE alarm)
+{
+	if(alarm == AL_FATALERROR)
+	{
+		fprintf(stderr, "fatal error alarm\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+void alarms_set_gain(const uint8_t uintGain)
+{
+	(void) uintGain;
+}
+
+/**
+ * \brief		Returns the gain that is applied to the trace.
+ */
+enum PGA112_GAINS stub_pga_getGain(void)
+{
+	return m_Gain;
+}
+
+/**
+ * \brief		Applies the gain queued with pga112_queueGain() (to be called right after each conversion).
+ */
+void stub_pga_writeQueued(void)
+{
+	if(m_blnQueued)
+	{
+		m_blnQueued = FALSE;
+		if(m_QueuedGain != m_Gain)
+			m_uintWrites++;
+		m_Gain = m_QueuedGain;
+	}
+}
+
+/**
+ * \brief		Returns the number of writes that changed the gain since the start of the replay.
+ */
+uint32_t stub_pga_getWrites(void)
+{
+	return m_uintWrites;
+}
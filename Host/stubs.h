@@ -0,0 +1,19 @@
+/**
+ * \file		stubs.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Header file of the host stand-ins for the PGA112 & alarms drivers.
+ */
+
+#ifndef __STUBS_H__
+#define __STUBS_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Prototypes
+//----------------------------------------------------------------------------------------------------------
+enum PGA112_GAINS	stub_pga_getGain(void);
+void				stub_pga_writeQueued(void);
+uint32_t			stub_pga_getWrites(void);
+
+#endif
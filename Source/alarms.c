@@ -95,6 +95,11 @@ void alarms_clear(enum ALARM_TYPE alarm)
 				LED_PORT |= (uint8_t) _BV(LED_RED);
 			break;
 
+			case AL_LEADOFF:
+				m_uintFlashingLEDs &= ~(_BV(LED_RED) | _BV(LED_BLUE));
+				LED_PORT |= (uint8_t) (_BV(LED_RED) | _BV(LED_BLUE));
+			break;
+
 			default:
 				alarms_set(AL_FATALERROR);
 			break;
@@ -156,6 +161,11 @@ void alarms_set(enum ALARM_TYPE alarm)
 				m_uintFlashingLEDs |= _BV(LED_RED);
 			break;
 
+			/// - \e Lead \e Off: Flashing Magenta (Red & Blue = Flashing)
+			case AL_LEADOFF:
+				m_uintFlashingLEDs |= (_BV(LED_RED) | _BV(LED_BLUE));
+			break;
+
 			/// - \e Fatal \e Error: Green & Blue = OFF, Red = ON
 			case AL_FATALERROR:
 			default:
@@ -169,32 +179,53 @@ void alarms_set(enum ALARM_TYPE alarm)
 //#endif
 }
 
+/**
+ * \brief		Shows a gain level on the LEDs (debugging aid).
+ *
+ * \details		Each of the eight gain levels has its own combination of the three (active-low) LEDs, from all LEDs
+ *				off at level 0 to all LEDs on at level 7. Other values raise a fatal error, like an invalid gain level
+ *				in ga_enterDisplayScale().
+ *
+ * \param[in]	uintGain	gain level (0 - 7)
+ */
 void alarms_set_gain(const uint8_t uintGain)
 {
 	switch(uintGain)
 	{
 		case 0:
-			LED_PORT = (uint8_t) (LED_PORT | (LED_GREEN | LED_BLUE | LED_RED));
+			LED_PORT = (uint8_t) (LED_PORT | (_BV(LED_GREEN) | _BV(LED_BLUE) | _BV(LED_RED)));
 		break;
 
 		case 1:
-			LED_PORT = (uint8_t) ((LED_PORT | (LED_GREEN | LED_RED)) & ~LED_BLUE);
+			LED_PORT = (uint8_t) ((LED_PORT | (_BV(LED_GREEN) | _BV(LED_RED))) & ~_BV(LED_BLUE));
 		break;
 
 		case 2:
-			LED_PORT = (uint8_t) ((LED_PORT | (LED_BLUE | LED_RED)) & ~LED_GREEN);
+			LED_PORT = (uint8_t) ((LED_PORT | (_BV(LED_BLUE) | _BV(LED_RED))) & ~_BV(LED_GREEN));
 		break;
 
 		case 3:
-			LED_PORT = (uint8_t) ((LED_PORT | LED_RED) & ~(LED_BLUE | LED_GREEN));
+			LED_PORT = (uint8_t) ((LED_PORT | _BV(LED_RED)) & ~(_BV(LED_BLUE) | _BV(LED_GREEN)));
 		break;
 
 		case 4:
-			LED_PORT = (uint8_t) ((LED_PORT & ~LED_RED) | (LED_GREEN | LED_BLUE));
+			LED_PORT = (uint8_t) ((LED_PORT & ~_BV(LED_RED)) | (_BV(LED_GREEN) | _BV(LED_BLUE)));
+		break;
+
+		case 5:
+			LED_PORT = (uint8_t) ((LED_PORT | _BV(LED_GREEN)) & ~(_BV(LED_BLUE) | _BV(LED_RED)));
+		break;
+
+		case 6:
+			LED_PORT = (uint8_t) ((LED_PORT | _BV(LED_BLUE)) & ~(_BV(LED_GREEN) | _BV(LED_RED)));
+		break;
+
+		case 7:
+			LED_PORT = (uint8_t) (LED_PORT & ~(_BV(LED_GREEN) | _BV(LED_BLUE) | _BV(LED_RED)));
 		break;
 
 		default:
-			LED_PORT = (uint8_t) (LED_PORT & ~(LED_GREEN | LED_BLUE | LED_RED));
-	
+			alarms_set(AL_FATALERROR);
+		break;
 	}
 }
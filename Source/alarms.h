@@ -51,6 +51,7 @@ enum ALARM_TYPE {AL_STANDBY = 0,	///< set LEDs for the standby state
 				 AL_KEY_PRESS,		///< 
 				 AL_KEY_HOLD,		///< 
 				 AL_MOVEMENT,		///< 
+				 AL_LEADOFF,		///< set LEDs to indicate that the electrodes are detached
 				 AL_FATALERROR		///< set LEDs to indicate that a fatal error has occured
 				};
 
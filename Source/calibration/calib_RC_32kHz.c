@@ -18,6 +18,7 @@
 //----------------------------------------------------------------------------------------------------------
 // AVR-LibC headers
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 
 // application headers
@@ -251,3 +252,38 @@ void calibRC_Calibrate(void)
 #endif
 #endif
 }
+
+/*! \brief Tracks the internal RC oscillator without blocking.
+*
+* Moves OSCCAL by one step towards the desired frequency if the CPU clock error
+* (measured by the caller against the external watch crystal, e.g. with
+* avr_tc1_getClockError()) exceeds TRACKING_DEADBAND_PPM. The step is taken
+* between two ADC conversions, and OSCCAL never crosses into the other half of
+* a split OSCCAL register (the two ranges overlap, so that would be a large jump).
+*
+* \return 1 if OSCCAL was changed (the caller's clock measurement is no longer valid), 0 otherwise
+*/
+unsigned char calibRC_Track(long clockError)
+{
+	unsigned char newOSCCAL = OSCCAL;
+
+	if ((clockError > TRACKING_DEADBAND_PPM) && ((newOSCCAL & 0x7F) != 0x00))
+		newOSCCAL--;													// Clock too fast: decrease speed
+	else if ((clockError < -TRACKING_DEADBAND_PPM) && ((newOSCCAL & 0x7F) != 0x7F))
+		newOSCCAL++;													// Clock too slow: increase speed
+	else
+		return 0;
+
+	cli();
+	while (ADCSRA & (1<<ADSC))											// Wait until no conversion is in progress
+	{
+		sei();
+		NOP();
+		cli();
+	}
+	OSCCAL = newOSCCAL;
+	NOP();
+	sei();
+
+	return 1;
+}
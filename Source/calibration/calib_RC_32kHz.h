@@ -48,6 +48,8 @@
 #define XTAL_FREQUENCY 32768															///< Frequency of the external oscillator. A 32kHz crystal is recommended
 #define EXTERNAL_TICKS 100																///< Number of ticks on XTAL. Modify to increase/decrease accuracy
 
+#define TRACKING_DEADBAND_PPM 5000														///< CPU clock error (in ppm) below which calibRC_Track() leaves OSCCAL alone (must be larger than half of an OSCCAL step so that the tracker doesn't toggle between two settings)
+
 // Fixed calibration values and macros.
 // ------------------------------------
 // These values are fixed and used by all calibration methods. Not to be modified.
@@ -91,5 +93,6 @@
 //----------------------------------------------------------------------------------------------------------
 void				calibRC_Init(void);
 void				calibRC_Calibrate(void);
+unsigned char		calibRC_Track(long clockError);
 
 #endif
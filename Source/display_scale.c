@@ -0,0 +1,132 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		display_scale.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ * \version		1.0.0
+ *
+ * \brief		Module that schedules the Display Scale episodes.
+ *
+ * \details		During a Display Scale episode the EEG output is replaced by the display scale signal, so starting an
+ *				episode for every gain change would blank the output for a long time when the gain changes several
+ *				times in a row. Instead, gain changes are only marked as pending and one episode is started for all of
+ *				them once:\n
+ *				- the gain hasn't changed for \a DS_STABLE_SEC, or the first pending change is \a DS_MAX_DEFER_SEC
+ *				  old, and\n
+ *				- at least \a DS_MIN_GAP_SEC of EEG were recorded since the previous episode.
+ *
+ *				Time is measured with the EEG sample index, i.e. only recorded time counts (the ADC is stopped during
+ *				the Display Scale state).
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// AVR-LibC headers
+#include <avr/io.h>
+
+// application headers
+#include "globals.h"
+#include "drivers/avr_adc.h"
+#include "drivers/avr_timer1.h"
+#include "display_scale.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Definitions
+//----------------------------------------------------------------------------------------------------------
+#define DS_STABLE_SAMPLES		((uint32_t) DS_STABLE_SEC*TMR1_SAMPLING_RATE_HZ)		///< DS_STABLE_SEC in EEG samples
+#define DS_MAX_DEFER_SAMPLES	((uint32_t) DS_MAX_DEFER_SEC*TMR1_SAMPLING_RATE_HZ)		///< DS_MAX_DEFER_SEC in EEG samples
+#define DS_MIN_GAP_SAMPLES		((uint32_t) DS_MIN_GAP_SEC*TMR1_SAMPLING_RATE_HZ)		///< DS_MIN_GAP_SEC in EEG samples
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+static BOOL						m_blnPending;					///< flag indicating that the gain was changed since the last episode
+static uint32_t					m_uintFirstChange;				///< sample index of the oldest pending gain change
+static uint32_t					m_uintLastChange;				///< sample index of the most recent gain change
+static uint32_t					m_uintLastEpisode;				///< sample index at which the last episode was started
+static struct DS_STATISTICS		m_Statistics;					///< statistics of the current recording session
+
+//----------------------------------------------------------------------------------------------------------
+//   								Code
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Initializes the module and starts a new recording session.
+ *
+ * \note		This function must be called before any other function in this module.
+ */
+void ds_init(void)
+{
+	m_blnPending = FALSE;
+	m_uintLastEpisode = avr_adc_getSampleIndex() - DS_MIN_GAP_SAMPLES;		// no gap required before the first episode
+	m_Statistics.uintGainChanges = 0;
+	m_Statistics.uintEpisodes = 0;
+	m_Statistics.uintBlankingSec = 0;
+}
+
+/**
+ * \brief		Registers a gain change that has to be followed by a Display Scale episode.
+ *
+ * \param[in]	uintSampleIndex		index of the EEG sample at which the gain was changed
+ */
+void ds_gainChanged(uint32_t uintSampleIndex)
+{
+	if(!m_blnPending)
+	{
+		m_blnPending = TRUE;
+		m_uintFirstChange = uintSampleIndex;
+	}
+	m_uintLastChange = uintSampleIndex;
+
+	if(m_Statistics.uintGainChanges < 0xFFFF)
+		m_Statistics.uintGainChanges++;
+}
+
+/**
+ * \brief		Checks whether a Display Scale episode should be started now.
+ *
+ * \return		TRUE if the pending gain changes are due to be displayed, FALSE otherwise
+ */
+BOOL ds_isDue(void)
+{
+	uint32_t uintSampleIndex;
+
+	if(!m_blnPending)
+		return FALSE;
+
+	uintSampleIndex = avr_adc_getSampleIndex();
+
+	if(uintSampleIndex - m_uintLastEpisode < DS_MIN_GAP_SAMPLES)
+		return FALSE;
+
+	return (uintSampleIndex - m_uintLastChange >= DS_STABLE_SAMPLES) || (uintSampleIndex - m_uintFirstChange >= DS_MAX_DEFER_SAMPLES);
+}
+
+/**
+ * \brief		Registers the start of a Display Scale episode.
+ *
+ * \details		Must be called for every episode (also the periodic ones), since an episode displays the current
+ *				gain and thereby covers all pending gain changes.
+ *
+ * \param[in]	uintDurationSec		duration of the episode (in sec)
+ */
+void ds_startEpisode(uint8_t uintDurationSec)
+{
+	m_blnPending = FALSE;
+	m_uintLastEpisode = avr_adc_getSampleIndex();
+
+	if(m_Statistics.uintEpisodes < 0xFFFF)
+		m_Statistics.uintEpisodes++;
+	m_Statistics.uintBlankingSec += uintDurationSec;
+}
+
+/**
+ * \brief		Returns the statistics of the current recording session.
+ *
+ * \param[out]	pStatistics		structure in which the statistics are stored
+ */
+void ds_getStatistics(struct DS_STATISTICS * pStatistics)
+{
+	*pStatistics = m_Statistics;
+}
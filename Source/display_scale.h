@@ -0,0 +1,41 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		display_scale.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Header file of module that schedules the Display Scale episodes.
+ */
+
+#ifndef __DISPLAY_SCALE_H__
+#define __DISPLAY_SCALE_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Application-Specific Definitions
+//----------------------------------------------------------------------------------------------------------
+#define DS_STABLE_SEC				2		///< time during which the gain must not change before a Display Scale episode is started (in sec)
+#define DS_MAX_DEFER_SEC			10		///< maximum time by which an episode is deferred while the gain keeps changing (in sec)
+#define DS_MIN_GAP_SEC				30		///< minimum amount of recorded EEG between two Display Scale episodes (in sec)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Statistics of the current recording session.
+ */
+struct DS_STATISTICS {uint16_t	uintGainChanges;		///< number of gain changes
+					  uint16_t	uintEpisodes;			///< number of Display Scale episodes (gain-triggered and periodic)
+					  uint32_t	uintBlankingSec;		///< total time during which the EEG output was replaced by the display scale signal (in sec)
+					 };
+
+//----------------------------------------------------------------------------------------------------------
+//   								Prototypes
+//----------------------------------------------------------------------------------------------------------
+void	ds_init(void);
+void	ds_gainChanged(uint32_t uintSampleIndex);
+BOOL	ds_isDue(void);
+void	ds_startEpisode(uint8_t uintDurationSec);
+void	ds_getStatistics(struct DS_STATISTICS * pStatistics);
+
+#endif
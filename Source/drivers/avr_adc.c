@@ -18,6 +18,7 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
+#include <util/atomic.h>
 
 // standard C headers (also from AVR-LibC)
 #include <math.h>
@@ -25,21 +26,140 @@
 
 // application headers
 #include "../globals.h"
+#include "../ring_buffer.h"
 #include "avr_adc.h"
 #include "avr_timer1.h"
+#include "pga112.h"
 #include "../alarms.h"
 
 //----------------------------------------------------------------------------------------------------------
 //   								Constants
 //----------------------------------------------------------------------------------------------------------
+#if (ADC_OVERSAMPLING > 1)
+#define ADC_PRESCALER_BITS		_BV(ADPS2)						///< Ck/16 ADC clock prescaler (250kHz @ 4MHz; slightly above the 200kHz recommended for 10-bit accuracy, but required for 4 conversions per EEG sampling period)
+#define ADC_EEG_PRESCALER		16UL							///< division factor of \a ADC_PRESCALER_BITS
+#elif (ADC_EEG_RESOLUTION > 8)
+#define ADC_PRESCALER_BITS		(_BV(ADPS2) | _BV(ADPS0))		///< Ck/32 ADC clock prescaler (125kHz @ 4MHz; full 10-bit accuracy requires 50-200kHz)
+#define ADC_EEG_PRESCALER		32UL							///< division factor of \a ADC_PRESCALER_BITS
+#else
+#define ADC_PRESCALER_BITS		_BV(ADPS2)						///< Ck/16 ADC clock prescaler (250kHz @ 4MHz; sufficient for 8-bit results)
+#define ADC_EEG_PRESCALER		16UL							///< division factor of \a ADC_PRESCALER_BITS
+#endif
+#define ADC_PRESCALER_MASK		(_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0))	///< ADC clock prescaler bits in ADCSRA
+
+#define ADC_ISR_CYCLES			150UL							///< estimated worst-case duration of the ADC ISR without a PGA write (in CPU cycles, including entry & exit)
+#define ADC_ISR_WRITE_CYCLES	(ADC_ISR_CYCLES + PGA112_WRITE_CYCLES)	///< estimated worst-case duration of the ADC ISR when it transmits a queued PGA write (in CPU cycles)
+#define ADC_ISR_ENTRY_CYCLES	50UL							///< estimated worst-case time from the completion of a conversion to the clearing of the trigger flag by the ADC ISR (in CPU cycles; interrupt response & register saving)
+
+#if (ADC_OVERSAMPLING == 1) && (ADC_RESOLUTION != 8) && (ADC_RESOLUTION != 10)
+#error "ADC_RESOLUTION must be 8 or 10"
+#endif
+
+#if (ADC_EEG_RESOLUTION > 8)
+#define ADC_ADMUX_BASE			_BV(REFS0)						///< AVCC pin as voltage reference; ADC Result Right-Adjusted
+#else
+#define ADC_ADMUX_BASE			(_BV(REFS0) | _BV(ADLAR))		///< AVCC pin as voltage reference; ADC Result Left-Adjusted
+#endif
+
+#if (ADC_OVERSAMPLING != 1) && (ADC_OVERSAMPLING != 4) && (ADC_OVERSAMPLING != 16)
+#error "ADC_OVERSAMPLING must be 1, 4 or 16"
+#endif
+
+#if (ADC_OVERSAMPLING > 1)
+#ifndef ADC_AUTO_TRIGGER
+#error "ADC_OVERSAMPLING requires ADC_AUTO_TRIGGER"
+#endif
+#ifdef ADC_SEQUENCER
+#error "ADC_OVERSAMPLING leaves no time for the ADC_SEQUENCER's conversions"
+#endif
+
+#define ADC_TRIGGER_CYCLES		((TMR1_PRESCALER * (1UL + TMR1_SAMPLING_OCR1A)) / ADC_OVERSAMPLING)	///< shortest interval between two conversion triggers (in CPU cycles; worst-case EEG sampling period, see \a TMR1_SAMPLING_OCR1A)
+
+// an auto-triggered conversion takes 13.5 ADC clock cycles; the ISR that handles it has to clear the trigger flag
+// before the next trigger, and must end before the next conversion completes so that the ISRs don't pile up. Only the
+// ISR of the last conversion of an EEG sample stores the sample and transmits a queued PGA write (the other ones
+// just accumulate), so the write may overlap the first conversion of the next EEG sample, which is skipped by the
+// gain adjustment's settling window.
+#if (((14UL * ADC_EEG_PRESCALER) + ADC_ISR_ENTRY_CYCLES) >= ADC_TRIGGER_CYCLES) || (ADC_ISR_WRITE_CYCLES >= ADC_TRIGGER_CYCLES)
+#error "ADC_OVERSAMPLING conversions and their ISRs don't fit in the worst-case EEG sampling period (see TMR1_SAMPLING_OCR1A)"
+#endif
+#endif
+
+#if defined(ADC_AUTO_TRIGGER) && (ADC_OVERSAMPLING == 1)
+// a queued PGA write is transmitted right after an EEG conversion and must be complete before the next conversion is
+// triggered (with the sequencer, the write is only transmitted in sampling periods without accelerometer conversion)
+#if (((14UL * ADC_EEG_PRESCALER) + ADC_ISR_WRITE_CYCLES) >= (TMR1_PRESCALER * (1UL + TMR1_SAMPLING_OCR1A)))
+#error "an EEG conversion and a queued PGA write don't fit in the worst-case EEG sampling period (see TMR1_SAMPLING_OCR1A)"
+#endif
+#endif
+
+#ifdef ADC_SEQUENCER
+#ifndef ADC_AUTO_TRIGGER
+#error "ADC_SEQUENCER requires ADC_AUTO_TRIGGER"
+#endif
+
+#define ADC_ACC_PRESCALER_BITS	(_BV(ADPS1) | _BV(ADPS0))		///< Ck/8 ADC clock prescaler used for the accelerometer conversions (only 8 bits are kept, so an ADC clock > 200 kHz is acceptable)
+#define ADC_ACC_PRESCALER		8UL							///< division factor of \a ADC_ACC_PRESCALER_BITS
+#define ADC_SEQUENCE_CYCLES		((14UL * (ADC_EEG_PRESCALER + 2UL * ADC_ACC_PRESCALER)) + (3UL * ADC_ISR_CYCLES))	///< worst-case duration of one sampling period's conversions (EEG + discarded settling conversion + accelerometer; 14 ADC clocks each incl. start-up)
+
+#if (ADC_SEQUENCE_CYCLES >= (TMR1_PRESCALER * (1UL + TMR1_SAMPLING_OCR1A)))
+#error "the sequencer's conversions don't fit in one EEG sampling period"
+#endif
+
+static const uint8_t mc_uintADMUXChannels[] = {_BV(MUX2) | _BV(MUX1) | _BV(MUX0),	// ADC_EEG: ADC7
+											   0,									// ADC_ACC_X: ADC0
+											   _BV(MUX0),							// ADC_ACC_Y: ADC1
+											   _BV(MUX1)};							///< MUX bits of each channel in \a ADC_SEQUENCE (ADC_ACC_Z: ADC2)
+static const uint8_t mc_uintSequenceDivisors[] = {ADC_ACC_X_DIVISOR,
+												  ADC_ACC_Y_DIVISOR,
+												  ADC_ACC_Z_DIVISOR};	///< conversion rate divisor of each accelerometer channel
+#endif
 
 //----------------------------------------------------------------------------------------------------------
 //   								Module Variables
 //----------------------------------------------------------------------------------------------------------
-volatile uint8_t				m_uintEEGSamples[256];					///< buffer in which the EEG samples are stored (256 was chosen as length so that the 8-bit read & write pointers wrap around by themselves when they overflow)
-volatile uint8_t				m_uintNUnreadSamplesEEG;				///< number of unread samples in \a m_uintEEGSamples
-volatile uint8_t				m_uintEEGSamplesWPtr;					///< position in \a m_uintEEGSamples where the next data sample will be stored
-volatile uint8_t				m_uintEEGSamplesRPtr;					///< position in \a m_uintEEGSamples from where a data sample will be read next
+RB_DEFINE(eeg, EEG_SAMPLE, ADC_EEG_BUFFER_LENGTH)						// ring buffer in which the EEG samples are stored (producer: ADC ISR; consumer: background loop)
+
+static volatile BOOL			m_blnEEGOverrun;						///< indicates whether the EEG ring buffer is currently full (used to count overrun events instead of dropped samples)
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+static volatile BOOL			m_blnEEGBlockInUse;						///< indicates whether the oldest block of the EEG ring buffer is currently being processed by the background loop
+#endif
+static volatile struct ADC_STATISTICS	m_Statistics;					///< EEG sample buffer statistics
+static volatile uint32_t		m_uintSampleIndex;						///< number of EEG samples acquired since power-up (monotonic; not reset by avr_adc_init())
+static uint32_t					m_uintBlockIndex;						///< sample index of the first sample of the block returned by avr_adc_getBlock()
+#ifdef ADC_NOISE_FLOOR
+static uint16_t					m_uintNoiseFloor = 0xFFFF;				///< lowest RMS noise estimate of an EEG block (only accessed by the background loop, so it is kept outside of \a m_Statistics)
+#endif
+
+#if (ADC_OVERSAMPLING > 1)
+static uint16_t					m_uintOversamplingSum;					///< sum of the conversions of the current EEG sample
+static uint8_t					m_uintOversamplingCount;				///< number of conversions that are still missing for the current EEG sample
+#endif
+
+#ifdef ADC_SEQUENCER
+RB_DEFINE(accx, uint8_t, ADC_ACC_BUFFER_LENGTH)							// ring buffer in which the X axis accelerometer samples are stored
+RB_DEFINE(accy, uint8_t, ADC_ACC_BUFFER_LENGTH)							// ring buffer in which the Y axis accelerometer samples are stored
+RB_DEFINE(accz, uint8_t, ADC_ACC_BUFFER_LENGTH)							// ring buffer in which the Z axis accelerometer samples are stored
+
+static volatile enum ADC_SEQUENCE	m_SequenceChannel;					///< channel that is currently being converted
+static volatile BOOL			m_blnSequenceSettling;					///< indicates whether the current conversion is the discarded one that follows a channel switch
+static uint8_t					m_uintSequenceCountdown[3];				///< number of EEG samples until each accelerometer channel is due
+#endif
+
+// variables from the PGA112 driver
+extern volatile BOOL			m_blnPGA112_Queued;
+extern volatile uint8_t			m_uintPGA112_Queued;
+
+#ifdef ADC_AUTO_TRIGGER
+// variables from the Timer/Counter1 driver
+extern volatile BOOL			m_blnTC1_StateTransition;
+extern volatile uint32_t		m_uintISRCount_OCR1A_State;
+extern volatile uint32_t		m_uintISRInterval_OCR1A_State;
+extern volatile uint16_t		m_uintTC1_PeriodTicks;
+extern volatile uint16_t		m_uintTC1_PeriodFraction;
+extern volatile uint16_t		m_uintTC1_Phase;
+extern volatile uint32_t		m_uintTC1_Ticks;
+#endif
 
 //----------------------------------------------------------------------------------------------------------
 //   								Code
@@ -57,17 +177,46 @@ volatile uint8_t				m_uintEEGSamplesRPtr;					///< position in \a m_uintEEGSampl
 void avr_adc_init(void)
 {
 	// initialize variables
-	m_uintNUnreadSamplesEEG  = m_uintEEGSamplesWPtr  = m_uintEEGSamplesRPtr  = 0;
+	rb_eeg_init();
+	m_blnEEGOverrun = FALSE;
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+	m_blnEEGBlockInUse = FALSE;
+#endif
+#if (ADC_OVERSAMPLING > 1)
+	m_uintOversamplingSum = 0;
+	m_uintOversamplingCount = ADC_OVERSAMPLING;
+#endif
 
 	// configure required Port A pins for ADC usage	
 	PORTA &= (uint8_t) ~(_BV(PA0) | _BV(PA1) | _BV(PA2) | _BV(PA7));	// no internal pull-up
 	DDRA  &= (uint8_t) ~(_BV(PA0) | _BV(PA1) | _BV(PA2) | _BV(PA7));	// set pins to input
 
-	// AVCC pin as voltage reference; ADC Result Left-Adjusted; Analog Channel ADC_EEG
-	ADMUX = (uint8_t) (_BV(REFS0) | _BV(ADLAR) | _BV(MUX2) | _BV(MUX1) | _BV(MUX0));
+	// AVCC pin as voltage reference; ADC Result Left-Adjusted (8-bit) or Right-Adjusted (10-bit); Analog Channel ADC_EEG
+	ADMUX = (uint8_t) (ADC_ADMUX_BASE | _BV(MUX2) | _BV(MUX1) | _BV(MUX0));
 
-	// ADC Interrupt Enable;  Clear Interrupt Flag; Ck/16 ADC Clock prescaler (250kHz @ 4MHz)
-	ADCSRA = (uint8_t) (_BV(ADIE) | _BV(ADPS2));
+#ifdef ADC_SEQUENCER
+	// accelerometer buffers & sequencer (the axes' slots are staggered so that they don't compete for the same EEG period)
+	rb_accx_init();
+	rb_accy_init();
+	rb_accz_init();
+	m_SequenceChannel = ADC_EEG;
+	m_blnSequenceSettling = FALSE;
+	m_uintSequenceCountdown[0] = 1;
+	m_uintSequenceCountdown[1] = 2;
+	m_uintSequenceCountdown[2] = 3;
+#endif
+
+#ifdef ADC_AUTO_TRIGGER
+	// Auto Trigger Source: Timer/Counter1 Compare Match B
+	ADCSRB = (uint8_t) (_BV(ADTS2) | _BV(ADTS0));
+
+	// ADC Enable; Auto Trigger Enable; ADC Interrupt Enable; ADC Clock prescaler
+	// NOTE: the ADC stays enabled until avr_adc_disable() is called, so only the very first conversion takes 25 ADC clock cycles
+	ADCSRA = (uint8_t) (_BV(ADEN) | _BV(ADATE) | _BV(ADIE) | ADC_PRESCALER_BITS);
+#else
+	// ADC Interrupt Enable;  Clear Interrupt Flag; ADC Clock prescaler
+	ADCSRA = (uint8_t) (_BV(ADIE) | ADC_PRESCALER_BITS);
+#endif
 }
 
 /**
@@ -77,8 +226,8 @@ void avr_adc_init(void)
  */
 void avr_adc_disable(void)
 {	
-	// stop ADC
-	ADCSRA &= (uint8_t) ~(_BV(ADEN));
+	// stop ADC (also stops auto triggering)
+	ADCSRA &= (uint8_t) ~(_BV(ADEN) | _BV(ADATE));
 }
 
 /**
@@ -89,7 +238,15 @@ void avr_adc_disable(void)
 void avr_adc_enable(void)
 {
 	// reset control variables
-	m_uintNUnreadSamplesEEG = m_uintEEGSamplesWPtr = m_uintEEGSamplesRPtr = 0;
+	rb_eeg_init();
+	m_blnEEGOverrun = FALSE;
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+	m_blnEEGBlockInUse = FALSE;
+#endif
+#if (ADC_OVERSAMPLING > 1)
+	m_uintOversamplingSum = 0;
+	m_uintOversamplingCount = ADC_OVERSAMPLING;
+#endif
 	
 	// start ADC
 	ADCSRA |= (uint8_t) (_BV(ADEN));
@@ -101,28 +258,360 @@ void avr_adc_startConversion(void)
 	ADCSRA |= (uint8_t) (_BV(ADSC));
 }
 
+/**
+ * \brief		Indicates whether a block of EEG samples is ready to be processed.
+ *
+ * \return		TRUE if avr_adc_getBlock() would return a block, FALSE otherwise
+ */
+BOOL avr_adc_isBlockReady(void)
+{
+	return (rb_eeg_count() >= ADC_EEG_BLOCK_LENGTH);
+}
+
+/**
+ * \brief		Returns the oldest block of EEG samples that is ready to be processed.
+ *
+ * \details		The block consists of \a ADC_EEG_BLOCK_LENGTH contiguous samples (the read pointer of the ring buffer
+ *				only advances in whole blocks) and belongs to the caller until avr_adc_releaseBlock() is called (the
+ *				ADC ISR keeps filling the ring buffer in the meantime).
+ *
+ * \return		pointer to the first sample of the block or NULL if no block is ready
+ */
+const EEG_SAMPLE * avr_adc_getBlock(void)
+{
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+	// prevent the ADC ISR from discarding the oldest block (must be set before the read pointer is read)
+	m_blnEEGBlockInUse = TRUE;
+#endif
+
+	if(rb_eeg_count() < ADC_EEG_BLOCK_LENGTH)
+	{
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+		m_blnEEGBlockInUse = FALSE;
+#endif
+		return NULL;
+	}
+
+	// the unread samples are the most recent ones
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		m_uintBlockIndex = m_uintSampleIndex - rb_eeg_count();
+	}
+
+	return rb_eeg_tail();
+}
+
+/**
+ * \brief		Returns the sample index of the first sample of the block returned by avr_adc_getBlock().
+ *
+ * \note		The index is exact unless samples were discarded due to a buffer overrun after the first sample of
+ *				the block was stored (the discarded samples are counted, but aren't in the buffer).
+ *
+ * \return		sample index (see avr_adc_getSampleIndex())
+ */
+uint32_t avr_adc_getBlockIndex(void)
+{
+	return m_uintBlockIndex;
+}
+
+/**
+ * \brief		Returns the monotonic EEG sample index.
+ *
+ * \details		The index is incremented by the ADC ISR for every EEG sample that is acquired (including samples
+ *				that are discarded due to buffer overruns) and is never reset, so it can be used as a common time base
+ *				(1 / \a TMR1_SAMPLING_RATE_HZ resolution) for all events.
+ *
+ * \return		number of EEG samples acquired since power-up (i.e. the index of the next sample)
+ */
+uint32_t avr_adc_getSampleIndex(void)
+{
+	uint32_t uintIndex;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		uintIndex = m_uintSampleIndex;
+	}
+
+	return uintIndex;
+}
+
+/**
+ * \brief		Hands the block returned by avr_adc_getBlock() back to the ADC driver.
+ *
+ * \details		When \a ADC_NOISE_FLOOR is defined, the block's noise is estimated before it is released. The lowest
+ *				estimate is a measure of the noise floor that is achieved by the acquisition (e.g. with the input
+ *				shorted or during quiet EEG segments) and can be read with avr_adc_getStatistics().
+ */
+void avr_adc_releaseBlock(void)
+{
+#ifdef ADC_NOISE_FLOOR
+	const EEG_SAMPLE * puintBlock = rb_eeg_tail();
+	uint32_t uintSum = 0;
+	uint16_t uintNoise;
+	uint8_t i;
+
+	// estimate the block's RMS noise from the mean absolute difference of consecutive samples (the difference
+	// suppresses the slowly varying EEG signal; for gaussian noise RMS = sqrt(pi)/2 * mean|x[i] - x[i-1]|)
+	for(i = 1; i < ADC_EEG_BLOCK_LENGTH; i++)
+	{
+		if(puintBlock[i] > puintBlock[i - 1])
+			uintSum += (uint16_t) (puintBlock[i] - puintBlock[i - 1]);
+		else
+			uintSum += (uint16_t) (puintBlock[i - 1] - puintBlock[i]);
+	}
+
+	// 907/64 ~ 16 * sqrt(pi)/2 (result in 1/16 LSB)
+	uintNoise = (uint16_t) ((uintSum * 907UL) / (64UL * (ADC_EEG_BLOCK_LENGTH - 1)));
+	if(uintNoise < m_uintNoiseFloor)
+		m_uintNoiseFloor = uintNoise;
+#endif
+
+	rb_eeg_skip(ADC_EEG_BLOCK_LENGTH);
+
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+	m_blnEEGBlockInUse = FALSE;
+#endif
+}
+
+#ifdef ADC_SEQUENCER
+/**
+ * \brief		Retrieves the oldest sample of an accelerometer channel.
+ *
+ * \param[in]	channel			accelerometer channel (\a ADC_ACC_X, \a ADC_ACC_Y or \a ADC_ACC_Z)
+ * \param[out]	puintSample		variable in which the sample is stored
+ *
+ * \return		TRUE if a sample was retrieved, FALSE if the channel's buffer is empty
+ */
+BOOL avr_adc_getAccSample(enum ADC_SEQUENCE channel, uint8_t * puintSample)
+{
+	switch(channel)
+	{
+		case ADC_ACC_X:
+			return rb_accx_get(puintSample);
+
+		case ADC_ACC_Y:
+			return rb_accy_get(puintSample);
+
+		case ADC_ACC_Z:
+			return rb_accz_get(puintSample);
+
+		default:
+			return FALSE;
+	}
+}
+#endif
+
+/**
+ * \brief		Copies the current EEG sample buffer statistics.
+ *
+ * \param[out]	pStatistics		structure in which the statistics are stored
+ */
+void avr_adc_getStatistics(struct ADC_STATISTICS * pStatistics)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*pStatistics = *((struct ADC_STATISTICS *) &m_Statistics);
+	}
+
+#ifdef ADC_NOISE_FLOOR
+	pStatistics->uintNoiseFloor = m_uintNoiseFloor;
+#endif
+}
+
+/**
+ * \brief		Resets the EEG sample buffer statistics.
+ *
+ * \note		The statistics are not reset by avr_adc_init(), so they cover all Recording state episodes since the last reset.
+ */
+void avr_adc_resetStatistics(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		m_Statistics.uintDroppedSamples = 0;
+		m_Statistics.uintOverruns = 0;
+		m_Statistics.uintMaxUnreadSamples = 0;
+	}
+
+#ifdef ADC_NOISE_FLOOR
+	m_uintNoiseFloor = 0xFFFF;
+#endif
+}
+
 /**
  * \brief		ADC Conversion Complete ISR
  *
  * \details		Performs the following tasks (in this order): \n - retrieves the data sample from the ADC data register and stores it in a temporary variable \n - resets the trigger source (if necessary) \n - stores the data sample in the appropriate data buffer \n - configures the ADC for the next conversion (if necessary)
+ *
+ * \note		When \a ADC_AUTO_TRIGGER is defined, the Timer/Counter1 Compare Match A interrupt is disabled and this ISR
+ *				also counts down the interval after which the Recording state is left.
+ *
+ * \note		When \a ADC_SEQUENCER is defined, an EEG conversion that completes can be followed (within the same
+ *				sampling period) by a discarded settling conversion and a conversion of the accelerometer channel that
+ *				is due. The ADMUX is switched back to the EEG channel right afterwards, so the EEG input has the
+ *				rest of the period to settle and the EEG conversions keep their Timer/Counter1 slots.
  */
 ISR(ADC_vect)
 {
-	PORTC ^= _BV(PC0);
+#ifdef ADC_SEQUENCER
+	uint8_t i;
+
+	if(m_SequenceChannel != ADC_EEG)
+	{
+		if(m_blnSequenceSettling)
+		{
+			// discard the first conversion after the channel switch and start the actual one
+			m_blnSequenceSettling = FALSE;
+			ADCSRA |= (uint8_t) _BV(ADSC);
+		}
+		else
+		{
+			// store accelerometer sample (8 MSBs only)
+#if (ADC_EEG_RESOLUTION > 8)
+			i = (uint8_t) (ADC >> 2);
+#else
+			i = ADCH;
+#endif
+			switch(m_SequenceChannel)
+			{
+				case ADC_ACC_X:
+					rb_accx_put(i);
+				break;
+
+				case ADC_ACC_Y:
+					rb_accy_put(i);
+				break;
+
+				default:
+					rb_accz_put(i);
+				break;
+			}
+
+			// switch back to the EEG channel and its clock prescaler
+			ADMUX = (uint8_t) (ADC_ADMUX_BASE | mc_uintADMUXChannels[ADC_EEG]);
+			ADCSRA = (uint8_t) ((ADCSRA & ~ADC_PRESCALER_MASK) | ADC_PRESCALER_BITS);
+			m_SequenceChannel = ADC_EEG;
+		}
+
+		return;
+	}
+#endif
+
+#ifdef ADC_AUTO_TRIGGER
+	// clear the trigger source's flag (its interrupt is disabled, so it isn't cleared by hardware) so that
+	// the next compare match starts a new conversion
+	TIFR1 = (uint8_t) _BV(OCF1B);
 
+	// length of the trigger period that has just started (crystal-disciplined)
+	TMR1_NEXT_PERIOD();
+#endif
+
+#if (ADC_OVERSAMPLING > 1)
+	// accumulate the conversions; only every ADC_OVERSAMPLING-th one completes an EEG sample
+	m_uintOversamplingSum += ADC;
+	if(--m_uintOversamplingCount != 0)
+		return;
+
+	// decimate
+	EEG_SAMPLE uintADCResult = (EEG_SAMPLE) (m_uintOversamplingSum >> ADC_DECIMATION_SHIFT);
+	m_uintOversamplingSum = 0;
+	m_uintOversamplingCount = ADC_OVERSAMPLING;
+#elif (ADC_EEG_RESOLUTION > 8)
+	// read full right-adjusted result (ADCL is read first by the compiler)
+	EEG_SAMPLE uintADCResult = ADC;
+#else
 	// read result from ADCH ( since result is left-adjusted
 	// due to ADLAR = 1, can read only ADCH)
-	uint8_t uintADCResult = ADCH;
+	EEG_SAMPLE uintADCResult = ADCH;
+#endif
+
+	PORTC ^= _BV(PC0);
+
+	m_uintSampleIndex++;
 	
+#ifdef ADC_AUTO_TRIGGER
+	// state transition
+	if(++m_uintISRCount_OCR1A_State == m_uintISRInterval_OCR1A_State)
+	{
+		m_blnTC1_StateTransition = TRUE;
+		m_uintISRCount_OCR1A_State = 0;
+	}
+#else
 	// disable ADC
 	ADCSRA &= (uint8_t) ~(_BV(ADEN));
+#endif
 		
 	// store new sample
-	m_uintEEGSamples[m_uintEEGSamplesWPtr++] = uintADCResult;
-
-	// increase # of unread samples variable
-	if(m_uintNUnreadSamplesEEG == 255)
-		m_uintNUnreadSamplesEEG = 0;
+	if(rb_eeg_put(uintADCResult))
+	{
+		m_blnEEGOverrun = FALSE;
+	}
 	else
-		m_uintNUnreadSamplesEEG++;
+	{
+		//
+		// buffer overrun
+		//
+		if(!m_blnEEGOverrun)
+		{
+			m_blnEEGOverrun = TRUE;
+			m_Statistics.uintOverruns++;
+
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_ALARM)
+			alarms_set(AL_FATALERROR);
+#endif
+		}
+
+#if (ADC_OVERRUN_POLICY == ADC_OVERRUN_DROP_OLDEST)
+		if(!m_blnEEGBlockInUse)
+		{
+			// discard the oldest block and store the new sample in the space that was freed
+			// (the ISR may only move the read pointer since the background loop isn't using the block)
+			rb_eeg_skip(ADC_EEG_BLOCK_LENGTH);
+			rb_eeg_put(uintADCResult);
+			m_Statistics.uintDroppedSamples += ADC_EEG_BLOCK_LENGTH;
+		}
+		else
+#endif
+		{
+			// discard the new sample
+			m_Statistics.uintDroppedSamples++;
+		}
+	}
+
+	// update high-water mark
+	if(rb_eeg_count() > m_Statistics.uintMaxUnreadSamples)
+		m_Statistics.uintMaxUnreadSamples = rb_eeg_count();
+
+#ifdef ADC_SEQUENCER
+	//
+	// schedule at most one accelerometer channel in the current sampling period
+	//
+	for(i = 0; i < 3; i++)
+	{
+		if(m_uintSequenceCountdown[i] != 0)
+			m_uintSequenceCountdown[i]--;
+
+		if(m_uintSequenceCountdown[i] == 0 && m_SequenceChannel == ADC_EEG)
+		{
+			m_uintSequenceCountdown[i] = mc_uintSequenceDivisors[i];
+			m_SequenceChannel = (enum ADC_SEQUENCE) (ADC_ACC_X + i);
+		}
+	}
+
+	if(m_SequenceChannel != ADC_EEG)
+	{
+		// switch channel & clock prescaler and start the settling conversion
+		m_blnSequenceSettling = TRUE;
+		ADMUX = (uint8_t) (ADC_ADMUX_BASE | mc_uintADMUXChannels[m_SequenceChannel]);
+		ADCSRA = (uint8_t) ((ADCSRA & ~ADC_PRESCALER_MASK) | ADC_ACC_PRESCALER_BITS | _BV(ADSC));
+	}
+#endif
+
+	//
+	// transmit a queued PGA gain change now that the EEG conversion is complete (with the sequencer only in
+	// sampling periods without accelerometer conversion, so that the sequence's timing budget is unaffected)
+	//
+#ifdef ADC_SEQUENCER
+	if(m_SequenceChannel == ADC_EEG)
+#endif
+		PGA112_WRITE_QUEUED();
 }
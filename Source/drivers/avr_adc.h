@@ -20,6 +20,42 @@
 //----------------------------------------------------------------------------------------------------------
 //   								Application-Specific Definitions
 //----------------------------------------------------------------------------------------------------------
+#define ADC_AUTO_TRIGGER						///< if defined, conversions are auto-triggered by the Timer/Counter1 Compare Match B event and the ADC stays enabled while recording (otherwise every conversion is started from the background loop)
+#ifndef ADC_OVERSAMPLING
+#define ADC_OVERSAMPLING						1				///< number of 10-bit conversions that are accumulated & decimated into one EEG sample: 1 (no oversampling), 4 (11-bit samples) or 16 (12-bit samples); requires \a ADC_AUTO_TRIGGER and excludes \a ADC_SEQUENCER; each conversion must fit in 1/\a ADC_OVERSAMPLING of the worst-case sampling period (\a TMR1_SAMPLING_OCR1A), which at 4 MHz rules out 16
+#endif
+#define ADC_RESOLUTION							8				///< resolution of the EEG samples without oversampling (\a ADC_OVERSAMPLING = 1; in bits): 8 (ADCH only, left-adjusted result) or 10 (full result, 16-bit samples)
+
+#if (ADC_OVERSAMPLING == 16)
+#define ADC_EEG_RESOLUTION						12				///< resolution of the EEG samples (in bits; given by \a ADC_OVERSAMPLING)
+#define ADC_DECIMATION_SHIFT					2				///< the sum of 16 10-bit conversions is shifted right by 2 bits (12-bit result)
+#elif (ADC_OVERSAMPLING == 4)
+#define ADC_EEG_RESOLUTION						11				///< resolution of the EEG samples (in bits; given by \a ADC_OVERSAMPLING)
+#define ADC_DECIMATION_SHIFT					1				///< the sum of 4 10-bit conversions is shifted right by 1 bit (11-bit result)
+#else
+#define ADC_EEG_RESOLUTION						ADC_RESOLUTION	///< resolution of the EEG samples (in bits; given by \a ADC_RESOLUTION)
+#endif
+
+#if (ADC_EEG_RESOLUTION > 8)
+#define ADC_EEG_BUFFER_LENGTH					128				///< length of the EEG sample buffer (must be a power of 2; halved for 16-bit samples so that the buffer still occupies 256 bytes of the 1 KB SRAM)
+#else
+#define ADC_EEG_BUFFER_LENGTH					256				///< length of the EEG sample buffer (must be a power of 2)
+#endif
+
+#define ADC_EEG_BLOCK_LENGTH					32				///< number of EEG samples in a block (must be a power of 2 and divide \a ADC_EEG_BUFFER_LENGTH); the background loop is notified once per block
+
+#define ADC_OVERRUN_DROP_NEWEST					0				///< overrun policy: new samples are discarded until there is room in the buffer
+#define ADC_OVERRUN_DROP_OLDEST					1				///< overrun policy: the oldest unprocessed block is discarded (falls back to \a ADC_OVERRUN_DROP_NEWEST while that block is being processed)
+#define ADC_OVERRUN_ALARM						2				///< overrun policy: same as \a ADC_OVERRUN_DROP_NEWEST, but a fatal error alarm is also raised
+#define ADC_OVERRUN_POLICY						ADC_OVERRUN_DROP_NEWEST	///< policy applied when the background loop falls behind and the EEG sample buffer overruns
+
+//#define ADC_SEQUENCER									///< if defined, accelerometer conversions are interleaved with the EEG conversions (requires \a ADC_AUTO_TRIGGER)
+#define ADC_ACC_X_DIVISOR						25				///< the X axis is converted once every \a ADC_ACC_X_DIVISOR EEG samples (100 Hz @ 2500 Hz)
+#define ADC_ACC_Y_DIVISOR						25				///< the Y axis is converted once every \a ADC_ACC_Y_DIVISOR EEG samples (100 Hz @ 2500 Hz)
+#define ADC_ACC_Z_DIVISOR						25				///< the Z axis is converted once every \a ADC_ACC_Z_DIVISOR EEG samples (100 Hz @ 2500 Hz)
+#define ADC_ACC_BUFFER_LENGTH					16				///< length of each accelerometer sample buffer (must be a power of 2)
+
+//#define ADC_NOISE_FLOOR									///< if defined, the noise of every processed EEG block is estimated and the lowest estimate is kept in the statistics
 
 //----------------------------------------------------------------------------------------------------------
 //   								Macros
@@ -30,18 +66,41 @@
 			ADCSRA |= (uint8_t) (_BV(ADEN));	\
 		} while(0)								///< macro used to clear Timer/Counter1
 
+#if (ADC_EEG_RESOLUTION > 8)
+#define PGM_READ_EEG_SAMPLE(addr)	pgm_read_word(addr)			///< macro used to read an \c EEG_SAMPLE from program memory
+#else
+#define PGM_READ_EEG_SAMPLE(addr)	pgm_read_byte(addr)			///< macro used to read an \c EEG_SAMPLE from program memory
+#endif
+
 //----------------------------------------------------------------------------------------------------------
 //   								Enums/Structs
 //----------------------------------------------------------------------------------------------------------
+#if (ADC_EEG_RESOLUTION > 8)
+typedef uint16_t EEG_SAMPLE;									///< data type used to store an EEG sample
+#else
+typedef uint8_t EEG_SAMPLE;										///< data type used to store an EEG sample
+#endif
+
 /**
- * States of the state maching that continually runs in the background loop.
+ * Channels converted by the ADC sequencer.
  */
-enum ADC_SEQUENCE {ADC_EEG = 0x00,		///< 
-				   ADC_ACC_X = 0x01,	///< Wake up from Power Save while in standby state
-				   ADC_ACC_Y = 0x02,	///< 
-				   ADC_ACC_Z = 0x03		///< 
+enum ADC_SEQUENCE {ADC_EEG = 0x00,		///< EEG (ADC7)
+				   ADC_ACC_X = 0x01,	///< accelerometer X axis (ADC0)
+				   ADC_ACC_Y = 0x02,	///< accelerometer Y axis (ADC1)
+				   ADC_ACC_Z = 0x03		///< accelerometer Z axis (ADC2)
 				 };
 
+/**
+ * Statistics of the EEG sample buffer (used to verify that the background loop keeps up with the sampling rate).
+ */
+struct ADC_STATISTICS {uint32_t	uintDroppedSamples;		///< number of EEG samples that were discarded due to buffer overruns
+					   uint16_t	uintOverruns;			///< number of buffer overruns (i.e. number of times the buffer became full)
+					   uint8_t	uintMaxUnreadSamples;	///< largest number of samples that were waiting to be processed at the same time (high-water mark; max. \a ADC_EEG_BUFFER_LENGTH - 1)
+#ifdef ADC_NOISE_FLOOR
+					   uint16_t	uintNoiseFloor;			///< lowest RMS noise estimate of an EEG block (in 1/16 LSB of the EEG samples; 0xFFFF if no block was processed yet)
+#endif
+					  };
+
 //----------------------------------------------------------------------------------------------------------
 //   								Prototypes
 //----------------------------------------------------------------------------------------------------------
@@ -49,5 +108,13 @@ void avr_adc_init(void);
 void avr_adc_disable(void);
 void avr_adc_enable(void);
 void avr_adc_startConversion(void);
+BOOL avr_adc_isBlockReady(void);
+const EEG_SAMPLE *	avr_adc_getBlock(void);
+uint32_t avr_adc_getBlockIndex(void);
+uint32_t avr_adc_getSampleIndex(void);
+void avr_adc_releaseBlock(void);
+BOOL avr_adc_getAccSample(enum ADC_SEQUENCE channel, uint8_t * puintSample);
+void avr_adc_getStatistics(struct ADC_STATISTICS * pStatistics);
+void avr_adc_resetStatistics(void);
 
 #endif
@@ -27,6 +27,24 @@
 //----------------------------------------------------------------------------------------------------------
 //   								Constants
 //----------------------------------------------------------------------------------------------------------
+#define TMR1_CS_MASK			(_BV(CS12) | _BV(CS11) | _BV(CS10))	///< clock select bits
+#define TMR1_CS_8				_BV(CS11)							///< clock select bits for the clk/8 prescaler (Recording state)
+#define TMR1_CS_64				(_BV(CS11) | _BV(CS10))				///< clock select bits for the clk/64 prescaler (Display Scale state)
+#define TMR1_SHIFT_64			3									///< log2(64/8): converts clk/64 ticks to clk/8 ticks
+
+#if defined(ADC_AUTO_TRIGGER) && (ADC_OVERSAMPLING == 16)
+#define TMR1_SHIFT_TRIGGER		4									///< log2(ADC_OVERSAMPLING): number of ADC triggers per EEG sample in the Recording state
+#elif defined(ADC_AUTO_TRIGGER) && (ADC_OVERSAMPLING == 4)
+#define TMR1_SHIFT_TRIGGER		2									///< log2(ADC_OVERSAMPLING): number of ADC triggers per EEG sample in the Recording state
+#else
+#define TMR1_SHIFT_TRIGGER		0									///< log2(ADC_OVERSAMPLING): number of ADC triggers per EEG sample in the Recording state
+#endif
+
+#define TMR1_TOSC_CYCLES		(128UL * (32768UL / (128UL * QTOUCH_MEAS_FREQUENCY_HZ)))	///< TOSC cycles per Timer/Counter2 compare match (see avr_tc2_init())
+#define TMR1_DISCIPLINE_DIVISOR	((uint32_t) TMR1_DISCIPLINE_WINDOW * TMR1_TOSC_CYCLES * TMR1_SAMPLING_RATE_HZ)	///< (clk/8 ticks per window) * 2^15 / TMR1_DISCIPLINE_DIVISOR = clk/8 ticks per EEG sample
+
+#define TMR1_PERIOD_LEGACY		((uint32_t) ((TMR1_SAMPLING_OCR1A + 1UL) << TMR1_SHIFT_64) << 16)	///< EEG sample period (in 1/65536 clk/8 ticks) used until the first measurement
+#define TMR1_PERIOD_NOMINAL		((uint32_t) (F_CPU / (8UL * TMR1_SAMPLING_RATE_HZ)) << 16)			///< EEG sample period (in 1/65536 clk/8 ticks) at the nominal CPU clock
 
 //----------------------------------------------------------------------------------------------------------
 //   								Module Variables
@@ -35,8 +53,40 @@ volatile BOOL				m_blnTC1_ADC;
 volatile BOOL				m_blnTC1_StateTransition;
 
 static enum TIMER1_MODE		m_Mode = TMR1_OFF;				///< 
-static volatile uint32_t	m_uintISRCount_OCR2A_State;		///< number of times the Timer/Counter2 overflow ISR has been called
-static volatile uint32_t	m_uintISRInterval_OCR2A_State;	///< number of times the Timer/Counter2 overflow ISR has been called
+static uint8_t				m_uintClockSelect;				///< clock select bits of the current operating mode
+static uint8_t				m_uintPeriodShift;				///< log2 of the number of compare matches per EEG sample period in clk/8 ticks (prescaler & ADC triggers of the current operating mode)
+volatile uint32_t			m_uintISRCount_OCR1A_State;		///< number of Timer/Counter1 compare match A events that occured since the last state transition
+volatile uint32_t			m_uintISRInterval_OCR1A_State;	///< number of Timer/Counter1 compare match A events after which a state transition is signaled
+
+static uint32_t				m_uintPeriod = TMR1_PERIOD_LEGACY;	///< disciplined EEG sample period (in 1/65536 clk/8 ticks; kept across operating modes)
+static int16_t				m_intRateError;					///< deviation of the achieved sample rate from \a TMR1_SAMPLING_RATE_HZ during the last measurement window (in ppm)
+static int32_t				m_intClockError;				///< deviation of the CPU clock from \a F_CPU during the last measurement window (in ppm)
+volatile uint16_t			m_uintTC1_PeriodTicks;			///< integer part of the current compare match period (in timer ticks)
+volatile uint16_t			m_uintTC1_PeriodFraction;		///< fractional part of the current compare match period (in 1/65536 timer ticks)
+volatile uint16_t			m_uintTC1_Phase;				///< phase accumulator of the fractional part
+volatile uint32_t			m_uintTC1_Ticks;				///< number of timer ticks up to the end of the current period (unwrapped count)
+
+static uint8_t				m_uintCrystalTicks;				///< number of Timer/Counter2 compare matches since the last capture
+static BOOL					m_blnCaptureValid;				///< indicates whether \a m_uintCapturePosition can be used as the start of a measurement window
+static uint32_t				m_uintCapturePosition;			///< unwrapped timer count at the last capture
+static volatile uint32_t	m_uintCaptureTicks;				///< number of timer ticks counted during the last measurement window
+static volatile BOOL		m_blnCaptureReady;				///< indicates whether \a m_uintCaptureTicks holds a new measurement
+
+//----------------------------------------------------------------------------------------------------------
+//   								Static Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Derives the compare match period of the current operating mode from \a m_uintPeriod.
+ *
+ * \note		Must be called with interrupts disabled.
+ */
+static void avr_tc1_setPeriod(void)
+{
+	uint32_t uintPeriod = m_uintPeriod >> m_uintPeriodShift;
+
+	m_uintTC1_PeriodTicks = (uint16_t) (uintPeriod >> 16);
+	m_uintTC1_PeriodFraction = (uint16_t) uintPeriod;
+}
 
 //----------------------------------------------------------------------------------------------------------
 //   								Code
@@ -44,6 +94,9 @@ static volatile uint32_t	m_uintISRInterval_OCR2A_State;	///< number of times the
 /**
  * \brief		Initializes the required driver variables and hardware registers for the AVR Timer/Counter1.
  *
+ * \details		The compare match period is derived from the EEG sample period that was last measured against the
+ *				TOSC crystal (see avr_tc1_discipline()), so the state change interval is counted in EEG samples.
+ *
  * state_change_interval		given in seconds
  */
 void avr_tc1_init(enum TIMER1_MODE mode, uint8_t state_change_interval)
@@ -52,23 +105,57 @@ void avr_tc1_init(enum TIMER1_MODE mode, uint8_t state_change_interval)
 
 	m_Mode = mode;
 	m_blnTC1_StateTransition = m_blnTC1_ADC = FALSE;
-	m_uintISRCount_OCR2A_State = 0;
+	m_uintISRCount_OCR1A_State = 0;
+
+	if(m_Mode == TMR1_RECORDING)
+	{
+		// Clock prescaler 8; ADC_OVERSAMPLING compare matches per EEG sample (the state transition interval is
+		// still counted in EEG samples)
+		m_uintClockSelect = TMR1_CS_8;
+		m_uintPeriodShift = TMR1_SHIFT_TRIGGER;
+	}
+	else
+	{
+		// Clock prescaler 64
+		m_uintClockSelect = TMR1_CS_64;
+		m_uintPeriodShift = TMR1_SHIFT_64;
+	}
+
+	// Initialize timer to CTC mode w/ TOP from OCR1A
+	TCCR1B = (uint8_t) (_BV(WGM12) | m_uintClockSelect);
 
-	// Initialize timer to CTC mode w/ TOP from OCR1A ; Clock prescaler 64
-	TCCR1B = (uint8_t) (_BV(WGM12) | _BV(CS11) | _BV(CS10));
+	// set the length of the first period
+	avr_tc1_setPeriod();
+	m_uintTC1_Phase = 0;
+	m_uintTC1_Ticks = 0;
+	TMR1_NEXT_PERIOD();
 
-	// set ADC's sampling rate: f = fIO/[64 * (1 + OCR1A)]
-	//OCR1A = 24;				//  2500 Hz
-	OCR1A = 17;				//  2500 Hz (actual w/ uncalibrated RC oscillator)
+	// start a new measurement window at the next Timer/Counter2 compare match
+	m_blnCaptureValid = m_blnCaptureReady = FALSE;
 
 	// set state 
-	m_uintISRInterval_OCR2A_State = (((uint32_t) 62500*state_change_interval)/((uint32_t) 1 + OCR1A)) - 1;;
+	m_uintISRInterval_OCR1A_State = (uint32_t) TMR1_SAMPLING_RATE_HZ * state_change_interval;
 
 	// clear timer
 	TCNT1 = 0;
 
+#ifdef ADC_AUTO_TRIGGER
+	if(m_Mode == TMR1_RECORDING)
+	{
+		// compare match B occurs at TOP and auto-triggers the ADC; the ADC ISR takes over the state transition
+		// count and the period updates, so no Timer/Counter1 interrupt is needed
+		TIFR1 = (uint8_t) (_BV(OCF1B) | _BV(OCF1A));
+		TIMSK1 = (uint8_t) 0;
+	}
+	else
+	{
+		// enable Output Compare A interrupt
+		TIMSK1 = (uint8_t) _BV(OCIE1A);
+	}
+#else
 	// enable Output Compare A interrupt
 	TIMSK1 = (uint8_t) _BV(OCIE1A);
+#endif
 }
 
 /**
@@ -79,10 +166,13 @@ void avr_tc1_init(enum TIMER1_MODE mode, uint8_t state_change_interval)
 void avr_tc1_restart(void)
 {
 	m_blnTC1_StateTransition = m_blnTC1_ADC = FALSE;
-	m_uintISRCount_OCR2A_State = 0;
+	m_uintISRCount_OCR1A_State = 0;
+
+	// the count jumps, so the current measurement window is lost
+	m_blnCaptureValid = m_blnCaptureReady = FALSE;
 	
-	// Clock prescaler 64
-	TCCR1B |= (uint8_t) (_BV(CS11) | _BV(CS10));
+	// reconnect the clock prescaler of the current operating mode
+	TCCR1B |= m_uintClockSelect;
 
 	// clear the timer/counter and its interrupt flags
 	TCNT1 = 0;
@@ -96,7 +186,169 @@ void avr_tc1_restart(void)
 void avr_tc1_stop(void)
 {
 	// stop the timer by clearing the clock source from TCCR1B
-	TCCR1B &= (uint8_t) ~(_BV(CS12) | _BV(CS11) | _BV(CS10));
+	TCCR1B &= (uint8_t) ~TMR1_CS_MASK;
+}
+
+/**
+ * \brief		Captures the unwrapped Timer/Counter1 count at a Timer/Counter2 compare match.
+ *
+ * \details		Must be called from the Timer/Counter2 Compare Match A ISR, whose period is derived from the 32.768 kHz
+ *				TOSC crystal. Every \a TMR1_DISCIPLINE_WINDOW calls, the number of timer ticks counted since the previous
+ *				capture is handed to avr_tc1_discipline().
+ */
+void avr_tc1_captureCrystalTick(void)
+{
+	uint8_t uintFlag;
+	uint16_t uintCount;
+	uint32_t uintPosition;
+
+	// the timer isn't running
+	if((TCCR1B & TMR1_CS_MASK) == 0)
+	{
+		m_blnCaptureValid = FALSE;
+		return;
+	}
+
+	if(m_blnCaptureValid && (++m_uintCrystalTicks < TMR1_DISCIPLINE_WINDOW))
+		return;
+
+	// flag that is set at TOP and cleared once the next period has been accounted for (by TMR1_NEXT_PERIOD())
+	uintFlag = (TIMSK1 & _BV(OCIE1A)) ? (uint8_t) _BV(OCF1A) : (uint8_t) _BV(OCF1B);
+
+	// position = ticks of the periods that ended + ticks of the current period (the count is re-read
+	// if TOP is reached while it is being read)
+	uintCount = TCNT1;
+	if(TIFR1 & uintFlag)
+	{
+		uintCount = TCNT1;
+		uintPosition = m_uintTC1_Ticks + uintCount;
+	}
+	else
+		uintPosition = m_uintTC1_Ticks - (OCR1A + 1UL) + uintCount;
+
+	if(m_blnCaptureValid)
+	{
+		m_uintCaptureTicks = uintPosition - m_uintCapturePosition;
+		m_blnCaptureReady = TRUE;
+	}
+
+	m_uintCapturePosition = uintPosition;
+	m_uintCrystalTicks = 0;
+	m_blnCaptureValid = TRUE;
+}
+
+/**
+ * \brief		Corrects the EEG sample period according to the last measurement against the TOSC crystal.
+ *
+ * \details		The CPU clock is measured by counting timer ticks over \a TMR1_DISCIPLINE_WINDOW crystal-timed
+ *				Timer/Counter2 periods. The new sample period (in 1/65536 timer ticks) is applied at the next compare
+ *				match, so drift of the RC oscillator (temperature, voltage) is tracked continuously. Measurements that
+ *				deviate by more than 50% from the nominal CPU clock are discarded.
+ *
+ * \note		Must be called periodically from the background loop (the division is too slow for an ISR).
+ *
+ * \return		TRUE if the sample period was updated, FALSE otherwise
+ */
+BOOL avr_tc1_discipline(void)
+{
+	uint32_t uintTicks, uintQuotient, uintRemainder;
+	int32_t intDifference;
+	uint8_t i;
+
+	if(!m_blnCaptureReady)
+		return FALSE;
+
+	cli();
+	uintTicks = m_uintCaptureTicks;
+	m_blnCaptureReady = FALSE;
+	sei();
+
+	// convert to clk/8 ticks
+	if(m_uintClockSelect == TMR1_CS_64)
+		uintTicks <<= TMR1_SHIFT_64;
+
+	// period = ticks * 2^15 / (window * TOSC cycles * rate) in 16.16 fixed-point, i.e. ticks * 2^31 / divisor
+	// (binary long division, since the numerator doesn't fit in 32 bits)
+	if(uintTicks >= TMR1_DISCIPLINE_DIVISOR)
+		return FALSE;
+
+	uintQuotient = 0;
+	uintRemainder = uintTicks;
+	for(i = 0; i < 31; i++)
+	{
+		uintRemainder <<= 1;
+		uintQuotient <<= 1;
+		if(uintRemainder >= TMR1_DISCIPLINE_DIVISOR)
+		{
+			uintRemainder -= TMR1_DISCIPLINE_DIVISOR;
+			uintQuotient |= 1;
+		}
+	}
+
+	// sanity check
+	if((uintQuotient < (TMR1_PERIOD_NOMINAL / 2)) || (uintQuotient > (TMR1_PERIOD_NOMINAL + TMR1_PERIOD_NOMINAL / 2)))
+		return FALSE;
+
+	// CPU clock error = (measured period - nominal period) / nominal period (both scaled down by 2^6 to avoid an overflow)
+	m_intClockError = (((int32_t) uintQuotient - (int32_t) TMR1_PERIOD_NOMINAL) / 64 * 15625) / (int32_t) (TMR1_PERIOD_NOMINAL / 64);
+
+	// achieved rate error = (ideal period - applied period) / applied period (resolution is kept by scaling
+	// the denominator instead of the numerator: 10^6 / 2^6 = 15625)
+	intDifference = (int32_t) uintQuotient - (int32_t) m_uintPeriod;
+	if(intDifference > 131071)
+		intDifference = 131071;
+	else if(intDifference < -131071)
+		intDifference = -131071;
+
+	intDifference = (intDifference * 15625) / (int32_t) (m_uintPeriod >> 6);
+	if(intDifference > INT16_MAX)
+		m_intRateError = INT16_MAX;
+	else if(intDifference < -INT16_MAX)
+		m_intRateError = -INT16_MAX;
+	else
+		m_intRateError = (int16_t) intDifference;
+
+	// apply new period
+	cli();
+	m_uintPeriod = uintQuotient;
+	avr_tc1_setPeriod();
+	sei();
+
+	return TRUE;
+}
+
+/**
+ * \brief		Returns the deviation of the achieved EEG sample rate from \a TMR1_SAMPLING_RATE_HZ.
+ *
+ * \details		The deviation is that of the sample period that was in effect during the last measurement window
+ *				(i.e. before the last correction). After the first correction it reflects the residual error of the
+ *				crystal-disciplined clock.
+ *
+ * \return		rate error in ppm (positive if samples are taken too fast; 0 if no measurement was made yet)
+ */
+int16_t avr_tc1_getRateError(void)
+{
+	return m_intRateError;
+}
+
+/**
+ * \brief		Returns the deviation of the CPU clock from \a F_CPU that was measured during the last measurement window.
+ *
+ * \return		clock error in ppm (positive if the clock is too fast; 0 if no measurement was made yet)
+ */
+int32_t avr_tc1_getClockError(void)
+{
+	return m_intClockError;
+}
+
+/**
+ * \brief		Discards the current measurement window (e.g. because the CPU clock was changed).
+ */
+void avr_tc1_restartMeasurement(void)
+{
+	cli();
+	m_blnCaptureValid = m_blnCaptureReady = FALSE;
+	sei();
 }
 
 //----------------------------------------------------------------------------------------------------------
@@ -108,14 +360,17 @@ ISR(TIMER1_COMPA_vect)
 	// ADC Trigger
 	//
 	m_blnTC1_ADC = TRUE;
+
+	// length of the period that has just started
+	TMR1_NEXT_PERIOD();
 	
 	//
 	// State transition
 	//
-	if(++m_uintISRCount_OCR2A_State == m_uintISRInterval_OCR2A_State)
+	if(++m_uintISRCount_OCR1A_State == m_uintISRInterval_OCR1A_State)
 	{
 		PORTC ^= (uint8_t) _BV(PC1);
 		m_blnTC1_StateTransition = TRUE;
-		m_uintISRCount_OCR2A_State = 0;
+		m_uintISRCount_OCR1A_State = 0;
 	}
 }
@@ -20,10 +20,27 @@
 //----------------------------------------------------------------------------------------------------------
 //   								Application-Specific Definitions
 //----------------------------------------------------------------------------------------------------------
+#define TMR1_PRESCALER				64		///< Timer/Counter1 clock prescaler in the Display Scale state (the Recording state uses clk/8 for a finer resolution of the sample period)
+#define TMR1_SAMPLING_OCR1A			17		///< TOP value (w/ \a TMR1_PRESCALER) of the sample period used until the first measurement against the TOSC crystal; also the worst-case period assumed by the ADC's timing checks: f = fIO/[TMR1_PRESCALER * (1 + OCR1A)] \n (nominal value for 2500 Hz is 24; 17 gives 2500 Hz w/ uncalibrated RC oscillator)
+#define TMR1_SAMPLING_RATE_HZ		2500	///< EEG sampling rate (in Hz) to which the sample period is disciplined
+#define TMR1_DISCIPLINE_WINDOW		16		///< number of Timer/Counter2 compare matches (~98 ms each, timed by the TOSC crystal) over which the CPU clock is measured
 
 //----------------------------------------------------------------------------------------------------------
 //   								Macros
 //----------------------------------------------------------------------------------------------------------
+#define TMR1_NEXT_PERIOD()																\
+		do																				\
+		{																				\
+			uint16_t uintTC1_Phase = m_uintTC1_Phase + m_uintTC1_PeriodFraction;		\
+			uint16_t uintTC1_Top = m_uintTC1_PeriodTicks - 1;							\
+																						\
+			if(uintTC1_Phase < m_uintTC1_Phase)											\
+				uintTC1_Top++;															\
+																						\
+			m_uintTC1_Phase = uintTC1_Phase;											\
+			OCR1A = OCR1B = uintTC1_Top;												\
+			m_uintTC1_Ticks += (uint16_t) (uintTC1_Top + 1);							\
+		} while(0)			///< macro that sets the length of the period that has just started (must be called once per compare match, before the counter reaches the shorter of the two TOP values); the fractional part of the disciplined period is realized by alternating between two TOP values
 
 #define CLEAR_TIMER1						\
 		do									\
@@ -48,5 +65,10 @@ enum TIMER1_MODE {TMR1_OFF = 0x00,			///<
 void		avr_tc1_init(enum TIMER1_MODE mode, uint8_t state_change_interval);
 void		avr_tc1_restart(void);
 void		avr_tc1_stop(void);
+void		avr_tc1_captureCrystalTick(void);
+BOOL		avr_tc1_discipline(void);
+int16_t		avr_tc1_getRateError(void);
+int32_t		avr_tc1_getClockError(void);
+void		avr_tc1_restartMeasurement(void);
 
 #endif
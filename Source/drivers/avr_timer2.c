@@ -23,6 +23,7 @@
 // application headers
 #include "../globals.h"
 #include "../alarms.h"
+#include "avr_timer1.h"
 #include "avr_timer2.h"
 
 //----------------------------------------------------------------------------------------------------------
@@ -198,6 +199,12 @@ ISR(TIMER2_COMPA_vect)
 		m_uintCurrentTimeTouch_msec += QTOUCH_MEAS_PERIOD_MSEC;
 	}
 
+	//
+	// Timer/Counter1 sample clock measurement
+	//
+	if((m_Mode == TMR2_RECORDING) || (m_Mode == TMR2_DISPSCALE))
+		avr_tc1_captureCrystalTick();
+
 	//
 	// USB connection Check
 	//
@@ -17,6 +17,7 @@
 
 // application headers
 #include "../globals.h"
+#include "../ring_buffer.h"
 #include "avr_usart-adc.h"
 
 extern uint8_t					m_uintGainStage;
@@ -24,10 +25,10 @@ extern uint8_t					m_uintGainStage;
 extern enum BACKGROUND_STATES	m_bkgState;
 
 extern volatile uint8_t			m_uintADCSequencePointer;
-extern volatile uint8_t			m_uintEEGSamples[256], m_uintXAccSamples[256], m_uintYAccSamples[256];
-extern volatile uint8_t			m_uintNUnreadSamplesEEG, m_uintNUnreadSamplesXAcc, m_uintNUnreadSamplesYAcc;
-extern volatile uint8_t			m_uintEEGSamplesRPtr, m_uintXAccSamplesRPtr, m_uintYAccSamplesRPtr;
-extern volatile uint8_t			m_uintEEGSamplesWPtr, m_uintXAccSamplesWPtr, m_uintYAccSamplesWPtr;
+
+RB_DEFINE(usart_eeg, uint8_t, 256)									// ring buffer in which the received EEG samples are stored (producer: USART RXC ISR; consumer: background loop)
+RB_DEFINE(usart_accx, uint8_t, 64)									// ring buffer in which the received X-axis acceleration samples are stored
+RB_DEFINE(usart_accy, uint8_t, 64)									// ring buffer in which the received Y-axis acceleration samples are stored
 
 //----------------------------------------------------------------------------------------------------------
 //   								Code
@@ -66,9 +67,9 @@ void avr_usart_init(enum BACKGROUND_STATES CurrentState)
 void avr_usart_enable(void)
 {
 	// reset control variables
-	m_uintNUnreadSamplesEEG = m_uintNUnreadSamplesXAcc = m_uintNUnreadSamplesYAcc = 0;
-	m_uintEEGSamplesWPtr = m_uintXAccSamplesWPtr = m_uintYAccSamplesWPtr = 0;
-	m_uintEEGSamplesRPtr = m_uintXAccSamplesRPtr = m_uintYAccSamplesRPtr = 0;
+	rb_usart_eeg_init();
+	rb_usart_accx_init();
+	rb_usart_accy_init();
 
 	// Turn on the transmission and reception circuitry; enable receive complete interrupt
 	UCSRB = (uint8_t) (RXEN | TXEN | RXCIE);
@@ -96,9 +97,8 @@ ISR(USART_RXC_vect)
 	// store received byte
 	uintReceivedByte = UDR;
 	
-	// store result and increment pointers
-	m_uintEEGSamples[m_uintEEGSamplesWPtr++] = uintReceivedByte;
-	m_uintNUnreadSamplesEEG++;									// wraps around by itself at 255 since it overflows
+	// store result (discarded if the buffer is full)
+	rb_usart_eeg_put(uintReceivedByte);
 	
 	// echo received byte back to PC
 	UDR = (uint8_t) m_uintGainStage;
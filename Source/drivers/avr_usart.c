@@ -17,11 +17,10 @@
 
 // application headers
 #include "../globals.h"
+#include "../ring_buffer.h"
 #include "avr_usart.h"
 
-static uint8_t						m_uintBuffer0[256];					///< buffer in which the data to be transmitted by the UART0 is stored (256 was chosen as length so that the 8-bit read & write pointers wrap around by themselves when they overflow)
-static volatile uint8_t				m_uintBuffer0WPtr;					///< position in \a m_uintBuffer where the next data byte to be transmitted will be stored (updated by )
-static volatile uint8_t				m_uintBuffer0RPtr;					///< position in \a m_uintBuffer from where the next data byte to be transmitted will be read
+RB_DEFINE(usart0_tx, uint8_t, 256)										// ring buffer in which the data to be transmitted by the UART0 is stored (producer: avr_usart0_send(); consumer: USART0 TX ISR)
 
 //----------------------------------------------------------------------------------------------------------
 //   								Globally-accessible Code
@@ -40,7 +39,7 @@ static volatile uint8_t				m_uintBuffer0RPtr;					///< position in \a m_uintBuff
  */
 void avr_usart0_init(void)
 {
-	m_uintBuffer0WPtr = m_uintBuffer0RPtr = 0;
+	rb_usart0_tx_init();
 
 	// set baud rate
 	UBRR0L = (uint8_t) BAUD_PRESCALE_NS;			// load lower 8-bits of the baud rate value into the low byte of the UBRR register
@@ -90,8 +89,8 @@ void avr_usart0_echo(void)
  * \brief		Sends data using USART0.
  *
  * \details		If there is enough room in the local buffer, the data to be transmitted gets copied to the local buffer.
- *				Afterwards, the transmission circuitry & interrupt are enabled, and the transmission is started by
- *				sending the first byte of data.
+ *				Afterwards, if no transmission is in progress, the transmission circuitry & interrupt are enabled, and
+ *				the transmission is started by sending the first byte of data.
  *
  * \return		TRUE if data was accepted for transmission (i.e. no buffer overflow), FALSE otherwise.
  *
@@ -100,31 +99,29 @@ void avr_usart0_echo(void)
  */
 BOOL avr_usart0_send(uint8_t * puintBuffer, uint8_t uintBufferLength)
 {
-	uint8_t i;
+	uint8_t uintByte;
 
-	if(uintBufferLength < 256)
+	// add data to UART buffer if enough space is available
+	if(uintBufferLength <= rb_usart0_tx_free())
 	{
-		// calculate emtpy buffer space
-		if(m_uintBuffer0RPtr < m_uintBuffer0WPtr)
-			i = 255 - (m_uintBuffer0WPtr - m_uintBuffer0RPtr);
-		else
-			i = 255 - (m_uintBuffer0RPtr - m_uintBuffer0WPtr);
-	
-		// add data to UART buffer if enough space is available
-		if(uintBufferLength <= i)
+		// transfer data to be sent to local buffer
+		rb_usart0_tx_write(puintBuffer, uintBufferLength);
+
+		// start transmission if the transmitter is idle (the TX ISR is the buffer's consumer
+		// only while a transmission is in progress)
+		cli();
+		if(!(UCSR0B & _BV(TXCIE0)))
 		{
-			// transfer data to be sent to local buffer
-			for(i = 0; i < uintBufferLength; i++)
-				m_uintBuffer0[m_uintBuffer0WPtr++] = puintBuffer[i];
-			
 			// enable transmission complete interrupt; turn on the transmission circuitry
-			UCSR0B = (uint8_t) _BV(TXCIE0) | _BV(TXEN0);
-			
-			// start transmission by sending first byte
-			UDR0 = m_uintBuffer0[m_uintBuffer0RPtr++];
+			UCSR0B = (uint8_t) (_BV(TXCIE0) | _BV(TXEN0));
 
-			return TRUE;
+			// start transmission by sending first byte
+			rb_usart0_tx_get(&uintByte);
+			UDR0 = uintByte;
 		}
+		sei();
+
+		return TRUE;
 	}
 
 	return FALSE;
@@ -140,8 +137,10 @@ BOOL avr_usart0_send(uint8_t * puintBuffer, uint8_t uintBufferLength)
  */
 ISR(USART0_TX_vect)
 {
-	if(m_uintBuffer0RPtr != m_uintBuffer0WPtr)
-		UDR0 = m_uintBuffer0[m_uintBuffer0RPtr++];
+	uint8_t uintByte;
+
+	if(rb_usart0_tx_get(&uintByte))
+		UDR0 = uintByte;
 	else
 		avr_usart0_disable();
 }
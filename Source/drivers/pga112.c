@@ -31,8 +31,7 @@
 // Read
 static uint8_t PGA112_READ_B2 = 0x6A;
 
-// Write
-static uint8_t PGA112_WRITE_B2 = 0x2A;
+// Write: PGA112_WRITE_B2 (defined in pga112.h, since PGA112_WRITE_QUEUED() uses it too)
 
 // Shutdown
 static uint8_t PGA112_SDN_B2 = 0xE1;
@@ -44,6 +43,8 @@ static uint8_t PGA112_SDN_B1_E = 0xF1;
 BOOL					m_blnSleeping;
 enum PGA112_GAINS		m_Gain;
 enum PGA112_CHANNELS	m_Channel;
+volatile BOOL			m_blnPGA112_Queued;		///< indicates whether a write is waiting to be transmitted by PGA112_WRITE_QUEUED()
+volatile uint8_t		m_uintPGA112_Queued;	///< second byte of the queued write command (gain & channel)
 
 //----------------------------------------------------------------------------------------------------------
 //   								Locally-accessible Code
@@ -121,6 +122,9 @@ static void pga112_write(uint8_t command)
 {
 	uint8_t uintByte1, uintByte0;
 
+	// the write supersedes a queued one (which, if it is still waiting, can no longer interrupt this one)
+	m_blnPGA112_Queued = FALSE;
+
 	uintByte1 = command;
 	uintByte0 = 0;
 	
@@ -186,6 +190,7 @@ void pga112_init(void)
 	// initialize variables
 	m_Gain = PGA112_G1;
 	m_Channel = PGA112_CH0;
+	m_blnPGA112_Queued = FALSE;
 }
 
 void pga112_getConfiguration(enum PGA112_CHANNELS * p_channel, enum PGA112_GAINS * p_gain)
@@ -209,13 +214,29 @@ void pga112_getConfiguration(enum PGA112_CHANNELS * p_channel, enum PGA112_GAINS
  */
 void pga112_setGain(enum PGA112_GAINS gain)
 {	
-	if(gain != m_Gain)
+	if((gain != m_Gain) || m_blnPGA112_Queued)
 	{
 		m_Gain = gain;
 		pga112_write(PGA112_WRITE_B2);
 	}
 }
 
+/**
+ * \brief		Queues a gain change that is transmitted by the ADC ISR right after the next EEG conversion.
+ *
+ * \details		The gain is thus never switched in the middle of a conversion, and the background loop doesn't wait
+ *				for the SPI transfer. The write is cancelled by any other write to the PGA112.
+ *
+ * \param[in]	gain	new gain
+ */
+void pga112_queueGain(enum PGA112_GAINS gain)
+{
+	m_blnPGA112_Queued = FALSE;
+	m_Gain = gain;
+	m_uintPGA112_Queued = (uint8_t) ((m_Gain << 4) | m_Channel);
+	m_blnPGA112_Queued = TRUE;
+}
+
 /**
  * \brief Disables the on-board ADC and its trigger source.
  *
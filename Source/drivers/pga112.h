@@ -43,9 +43,52 @@
 #define PGA112_MISO				PD2 	///< port pin to which the Data Bus pin 7 (DB7) is connected
 
 #endif
+#define PGA112_WRITE_B2			0x2A	///< first byte of the write command (the second byte holds the gain & channel); shared with PGA112_WRITE_QUEUED()
+
 //----------------------------------------------------------------------------------------------------------
 //   								Application-Specific Definitions
 //----------------------------------------------------------------------------------------------------------
+#define PGA112_WRITE_CYCLES		100UL	///< estimated worst-case duration of PGA112_WRITE_QUEUED() (in CPU cycles)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Macros
+//----------------------------------------------------------------------------------------------------------
+#ifndef USE_USART1_SPI
+#define PGA112_WRITE_QUEUED()														\
+		do																			\
+		{																			\
+			if(m_blnPGA112_Queued)													\
+			{																		\
+				PGA112_PORT &= (uint8_t) ~_BV(PGA112_SS);							\
+				SPDR = PGA112_WRITE_B2;											\
+				while(!(SPSR & _BV(SPIF)));											\
+				SPDR = m_uintPGA112_Queued;											\
+				while(!(SPSR & _BV(SPIF)));											\
+				(void) SPDR;														\
+				PGA112_PORT |= (uint8_t) _BV(PGA112_SS);							\
+				m_blnPGA112_Queued = FALSE;											\
+			}																		\
+		} while(0)			///< macro that transmits a write queued by pga112_queueGain() (to be called from an ISR right after an ADC conversion)
+#else
+#define PGA112_WRITE_QUEUED()														\
+		do																			\
+		{																			\
+			if(m_blnPGA112_Queued)													\
+			{																		\
+				PGA112_PORT &= (uint8_t) ~_BV(PGA112_SS);							\
+				UDR1 = PGA112_WRITE_B2;											\
+				while(!(UCSR1A & _BV(UDRE1)));										\
+				UDR1 = m_uintPGA112_Queued;											\
+				while(!(UCSR1A & _BV(TXC1)));										\
+				while(UCSR1A & _BV(RXC1))											\
+					(void) UDR1;													\
+				PGA112_PORT |= (uint8_t) _BV(PGA112_SS);							\
+				UCSR1A |= (uint8_t) _BV(TXC1);										\
+				m_blnPGA112_Queued = FALSE;											\
+			}																		\
+		} while(0)			///< macro that transmits a write queued by pga112_queueGain() (to be called from an ISR right after an ADC conversion)
+#endif
+
 
 //----------------------------------------------------------------------------------------------------------
 //   								Enums/Structs
@@ -80,6 +123,7 @@ enum PGA112_CHANNELS {PGA112_CH0 = 0,
 void pga112_init(void);
 void pga112_getConfiguration(enum PGA112_CHANNELS * p_channel, enum PGA112_GAINS * p_gain);
 void pga112_setGain(enum PGA112_GAINS gain);
+void pga112_queueGain(enum PGA112_GAINS gain);
 void pga112_setChannel(enum PGA112_CHANNELS channel);
 void pga112_sleep(BOOL blnSleep);
 
@@ -0,0 +1,312 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		dsp.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Fixed-point signal processing primitives.
+ *
+ * \details		All functions are \c static \c inline, so only the ones that are used take up program memory and
+ *				calls with constant shifts are reduced to straight-line code.\n
+ *				Number formats:\n
+ *				- Q7: \c int8_t, range [-1, 1 - 2^-7]\n
+ *				- Q15: \c int16_t, range [-1, 1 - 2^-15]\n
+ *				- Q31: \c int32_t, range [-1, 1 - 2^-31] (accumulator of the Q15 multiply-accumulate)\n
+ *				- Q14: \c int16_t, range [-2, 2 - 2^-14] (biquad coefficients)
+ *
+ *				On devices with a hardware multiplier the multiplications use the AVR's \c FMULS/\c FMULSU/\c FMUL
+ *				instructions (see also Atmel application note AVR201); elsewhere (e.g. when the code is compiled
+ *				for the host) plain C code that yields the same results is used instead (Host/dsp_check.c checks the
+ *				assembly sequences against the C code). Cycle counts are only given for the assembly sequences, whose
+ *				cost doesn't depend on the compiler; the cost of the C code has to be measured on the device.
+ *
+ *				A file that includes this header must include <stdint.h> first.
+ */
+
+#ifndef __DSP_H__
+#define __DSP_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Definitions
+//----------------------------------------------------------------------------------------------------------
+#if defined(__AVR__) && (defined(__AVR_HAVE_MUL__) || defined(__AVR_ENHANCED__))
+	#define DSP_HW_MUL													///< set if the hardware multiplier (MUL/FMUL instructions) is available
+#endif
+
+#define DSP_Q14(x)		((int16_t) ((x) * 16384.0 + (((x) < 0) ? -0.5 : 0.5)))		///< converts a floating-point constant into a Q14 value (compile-time only)
+#define DSP_Q15(x)		((int16_t) ((x) * 32768.0 + (((x) < 0) ? -0.5 : 0.5)))		///< converts a floating-point constant (< 1) into a Q15 value (compile-time only)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Coefficients of a biquad section (Q14):\n
+ * y[n] = b0 * x[n] + b1 * x[n - 1] + b2 * x[n - 2] - a1 * y[n - 1] - a2 * y[n - 2]
+ */
+struct DSP_BIQUAD_COEFS {int16_t	intB0;		///< b0
+						 int16_t	intB1;		///< b1
+						 int16_t	intB2;		///< b2
+						 int16_t	intA1;		///< a1
+						 int16_t	intA2;		///< a2
+						};
+
+/**
+ * State of a biquad section (direct form I).
+ */
+struct DSP_BIQUAD {int16_t	intX1;		///< x[n - 1]
+				   int16_t	intX2;		///< x[n - 2]
+				   int16_t	intY1;		///< y[n - 1]
+				   int16_t	intY2;		///< y[n - 2]
+				  };
+
+//----------------------------------------------------------------------------------------------------------
+//   								Saturating Arithmetic
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Saturating Q7 addition.
+ */
+static inline int8_t dsp_addQ7(int8_t a, int8_t b)
+{
+	int16_t intSum = (int16_t) a + b;
+
+	if(intSum > INT8_MAX)
+		return INT8_MAX;
+	if(intSum < INT8_MIN)
+		return INT8_MIN;
+
+	return (int8_t) intSum;
+}
+
+/**
+ * \brief		Saturating Q15 addition.
+ */
+static inline int16_t dsp_addQ15(int16_t a, int16_t b)
+{
+	int16_t intSum = (int16_t) ((uint16_t) a + (uint16_t) b);
+
+	// an overflow occurred if both operands have the same sign and the sign of the sum differs
+	if(((a ^ intSum) & (b ^ intSum)) < 0)
+		return (a < 0) ? INT16_MIN : INT16_MAX;
+
+	return intSum;
+}
+
+/**
+ * \brief		Saturating Q31 addition.
+ */
+static inline int32_t dsp_addQ31(int32_t a, int32_t b)
+{
+	int32_t intSum = (int32_t) ((uint32_t) a + (uint32_t) b);
+
+	if(((a ^ intSum) & (b ^ intSum)) < 0)
+		return (a < 0) ? INT32_MIN : INT32_MAX;
+
+	return intSum;
+}
+
+//----------------------------------------------------------------------------------------------------------
+//   								Multiplication
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Fractional Q7 x Q7 multiplication with a Q15 result.
+ *
+ * \details		-1 * -1 saturates to 1 - 2^-15. The FMULS sequence takes 4 cycles.
+ */
+static inline int16_t dsp_fmulQ7(int8_t a, int8_t b)
+{
+	int16_t intProduct;
+
+	if((a == INT8_MIN) && (b == INT8_MIN))
+		return INT16_MAX;
+
+#ifdef DSP_HW_MUL
+	__asm__ ("fmuls	%[a], %[b]"		"\n\t"
+			 "movw	%[p], r0"		"\n\t"
+			 "clr	__zero_reg__"
+			 : [p] "=r" (intProduct)
+			 : [a] "a" (a), [b] "a" (b));
+#else
+	intProduct = (int16_t) (a * b * 2);
+#endif
+
+	return intProduct;
+}
+
+/**
+ * \brief		Fractional Q15 x Q15 multiplication with a Q31 result.
+ *
+ * \details		-1 * -1 saturates to 1 - 2^-31. The AVR201 sequence takes 21 cycles.
+ */
+static inline int32_t dsp_fmulQ15(int16_t a, int16_t b)
+{
+	int32_t intProduct;
+
+	if((a == INT16_MIN) && (b == INT16_MIN))
+		return INT32_MAX;
+
+#ifdef DSP_HW_MUL
+	uint8_t uintZero;
+
+	// (ah * bh << 17) + (al * bl << 1) + (ah * bl << 9) + (bh * al << 9)
+	__asm__ ("clr	%[z]"				"\n\t"
+			 "fmuls	%B[a], %B[b]"		"\n\t"
+			 "movw	%C[p], r0"			"\n\t"
+			 "fmul	%A[a], %A[b]"		"\n\t"
+			 "adc	%C[p], %[z]"		"\n\t"
+			 "movw	%A[p], r0"			"\n\t"
+			 "fmulsu	%B[a], %A[b]"	"\n\t"
+			 "sbc	%D[p], %[z]"		"\n\t"
+			 "add	%B[p], r0"			"\n\t"
+			 "adc	%C[p], r1"			"\n\t"
+			 "adc	%D[p], %[z]"		"\n\t"
+			 "fmulsu	%B[b], %A[a]"	"\n\t"
+			 "sbc	%D[p], %[z]"		"\n\t"
+			 "add	%B[p], r0"			"\n\t"
+			 "adc	%C[p], r1"			"\n\t"
+			 "adc	%D[p], %[z]"		"\n\t"
+			 "clr	__zero_reg__"
+			 : [p] "=&r" (intProduct), [z] "=&r" (uintZero)
+			 : [a] "a" (a), [b] "a" (b));
+#else
+	intProduct = (int32_t) ((uint32_t) ((int32_t) a * b) << 1);
+#endif
+
+	return intProduct;
+}
+
+/**
+ * \brief		Fractional Q7 multiplication (the result is truncated).
+ */
+static inline int8_t dsp_mulQ7(int8_t a, int8_t b)
+{
+	return (int8_t) (dsp_fmulQ7(a, b) >> 8);
+}
+
+/**
+ * \brief		Fractional Q15 multiplication (the result is truncated).
+ */
+static inline int16_t dsp_mulQ15(int16_t a, int16_t b)
+{
+	return (int16_t) (dsp_fmulQ15(a, b) >> 16);
+}
+
+/**
+ * \brief		Saturating Q7 multiply-accumulate: acc + a * b.
+ *
+ * \param[in]	intAcc	accumulator (Q15)
+ */
+static inline int16_t dsp_macQ7(int16_t intAcc, int8_t a, int8_t b)
+{
+	return dsp_addQ15(intAcc, dsp_fmulQ7(a, b));
+}
+
+/**
+ * \brief		Saturating Q15 multiply-accumulate: acc + a * b.
+ *
+ * \param[in]	intAcc	accumulator (Q31)
+ */
+static inline int32_t dsp_macQ15(int32_t intAcc, int16_t a, int16_t b)
+{
+	return dsp_addQ31(intAcc, dsp_fmulQ15(a, b));
+}
+
+//----------------------------------------------------------------------------------------------------------
+//   								Filters
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		First-order low-pass filter step with separate time constants for rising & falling inputs.
+ *
+ * \details		state += (x - state) / 2^n, with n = \a uintRiseShift if the input lies above the state and
+ *				n = \a uintFallShift otherwise. The state never overshoots the input, so (x - state) keeps the sign of
+ *				(x - previous state). Fractional bits are up to the caller (e.g. x << m with m <= 16 - input bits).
+ *
+ * \param[in]	uintState		filter state (previous output)
+ * \param[in]	uintInput		new input
+ * \param[in]	uintRiseShift	time constant for inputs above the state (2^n steps)
+ * \param[in]	uintFallShift	time constant for inputs below the state (2^n steps)
+ *
+ * \return		new filter state (= output)
+ */
+static inline uint16_t dsp_trackU16(uint16_t uintState, uint16_t uintInput, uint8_t uintRiseShift, uint8_t uintFallShift)
+{
+	if(uintInput > uintState)
+		uintState += (uint16_t) (uintInput - uintState) >> uintRiseShift;
+	else
+		uintState -= (uint16_t) (uintState - uintInput) >> uintFallShift;
+
+	return uintState;
+}
+
+/**
+ * \brief		First-order low-pass filter step (exponential moving average): state += (x - state) / 2^n.
+ *
+ * \see			dsp_trackU16()
+ */
+static inline uint16_t dsp_iir1U16(uint16_t uintState, uint16_t uintInput, uint8_t uintShift)
+{
+	return dsp_trackU16(uintState, uintInput, uintShift, uintShift);
+}
+
+/**
+ * \brief		Biquad filter step (direct form I, Q14 coefficients).
+ *
+ * \details		The products are accumulated with saturation in 32 bits and the output is rounded and saturated
+ *				to 16 bits, so the filter does not wrap around on overload. Because the coefficients are Q14, a1 may
+ *				take values up to 2 (poles close to z = 1), but a1 & a2 must not be -2 (they are negated); the samples need enough headroom for the filter's gain.
+ *
+ * \param[in]	pState		state of the filter
+ * \param[in]	pCoefs		coefficients of the filter
+ * \param[in]	intInput	new input sample
+ *
+ * \return		new output sample
+ */
+static inline int16_t dsp_biquad(struct DSP_BIQUAD * pState, const struct DSP_BIQUAD_COEFS * pCoefs, int16_t intInput)
+{
+	int32_t intAcc;
+	int16_t intOutput;
+
+	// Q14 * Q0 << 1 => 15 fractional bits
+	intAcc = dsp_fmulQ15(pCoefs->intB0, intInput);
+	intAcc = dsp_macQ15(intAcc, pCoefs->intB1, pState->intX1);
+	intAcc = dsp_macQ15(intAcc, pCoefs->intB2, pState->intX2);
+	intAcc = dsp_macQ15(intAcc, (int16_t) -pCoefs->intA1, pState->intY1);
+	intAcc = dsp_macQ15(intAcc, (int16_t) -pCoefs->intA2, pState->intY2);
+	intAcc = dsp_addQ31(intAcc, 1L << 14) >> 15;
+
+	if(intAcc > INT16_MAX)
+		intOutput = INT16_MAX;
+	else if(intAcc < INT16_MIN)
+		intOutput = INT16_MIN;
+	else
+		intOutput = (int16_t) intAcc;
+
+	pState->intX2 = pState->intX1;
+	pState->intX1 = intInput;
+	pState->intY2 = pState->intY1;
+	pState->intY1 = intOutput;
+
+	return intOutput;
+}
+
+/**
+ * \brief		Moving-average filter step.
+ *
+ * \details		The window (2^n samples) is kept by the caller, e.g. in a ring buffer; the function only
+ *				updates the running sum, so the cost does not depend on the length of the window.
+ *
+ * \param[in,out]	pSum			running sum of the samples in the window (initially 0 with the window cleared)
+ * \param[in]		intInput		sample entering the window
+ * \param[in]		intOldest		sample leaving the window
+ * \param[in]		uintLengthShift	base-2 logarithm of the window length
+ *
+ * \return		mean of the window (rounded down)
+ */
+static inline int16_t dsp_movingAverage(int32_t * pSum, int16_t intInput, int16_t intOldest, uint8_t uintLengthShift)
+{
+	*pSum += (int32_t) intInput - intOldest;
+
+	return (int16_t) (*pSum >> uintLengthShift);
+}
+
+#endif
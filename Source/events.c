@@ -0,0 +1,107 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		events.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ * \version		1.0.0
+ *
+ * \brief		Module that timestamps events against the EEG sample index.
+ *
+ * \details		Events are stamped with the monotonic sample index that is maintained by the ADC driver, so that
+ *				telemetry or log output can be aligned to the exact EEG sample. Events must only be stamped from the
+ *				background loop (the ISRs keep counting, e.g. the overruns, and the background loop turns the counts
+ *				into events), so the event buffer has a single producer and needs no interrupt locking.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// AVR-LibC headers
+#include <avr/io.h>
+
+// application headers
+#include "globals.h"
+#include "ring_buffer.h"
+#include "drivers/avr_adc.h"
+#include "events.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+RB_DEFINE(events, struct EV_EVENT, EV_BUFFER_LENGTH)			// buffer in which the events are stored until they are read
+
+static uint8_t	m_uintLostEvents;								///< number of events that were discarded because the buffer was full (saturates at 255)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Code
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Initializes the module.
+ *
+ * \note		This function must be called before any other function in this module.
+ */
+void ev_init(void)
+{
+	rb_events_init();
+	m_uintLostEvents = 0;
+}
+
+/**
+ * \brief		Timestamps an event with the index of the next EEG sample.
+ *
+ * \details		The stamp is avr_adc_getSampleIndex(), i.e. the index of the next sample to be acquired (one past the
+ *				most recent sample): the event happened after all samples with a lower index. It is also valid before
+ *				the first sample (index 0).
+ *
+ * \param[in]	type		type of the event
+ * \param[in]	uintParam	type-dependent parameter (see \c EV_TYPE)
+ */
+void ev_stamp(enum EV_TYPE type, uint8_t uintParam)
+{
+	ev_stampAt(type, uintParam, avr_adc_getSampleIndex());
+}
+
+/**
+ * \brief		Timestamps an event with a given EEG sample index.
+ *
+ * \details		Used when the event is caused by a particular sample (e.g. a gain change that is decided while a
+ *				block of samples is processed).
+ *
+ * \param[in]	type				type of the event
+ * \param[in]	uintParam			type-dependent parameter (see \c EV_TYPE)
+ * \param[in]	uintSampleIndex		index of the EEG sample with which the event coincides
+ */
+void ev_stampAt(enum EV_TYPE type, uint8_t uintParam, uint32_t uintSampleIndex)
+{
+	struct EV_EVENT event;
+
+	event.uintSampleIndex = uintSampleIndex;
+	event.type = (uint8_t) type;
+	event.uintParam = uintParam;
+
+	if(!rb_events_put(event) && (m_uintLostEvents < 0xFF))
+		m_uintLostEvents++;
+}
+
+/**
+ * \brief		Retrieves the oldest event.
+ *
+ * \param[out]	pEvent		structure in which the event is stored
+ *
+ * \return		TRUE if an event was retrieved, FALSE if there are no events
+ */
+BOOL ev_get(struct EV_EVENT * pEvent)
+{
+	return rb_events_get(pEvent);
+}
+
+/**
+ * \brief		Returns the number of events that were discarded because they weren't read in time.
+ *
+ * \return		number of lost events (saturates at 255)
+ */
+uint8_t ev_getLost(void)
+{
+	return m_uintLostEvents;
+}
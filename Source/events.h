@@ -0,0 +1,49 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		events.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Header file of module that timestamps events against the EEG sample index.
+ */
+
+#ifndef __EVENTS_H__
+#define __EVENTS_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Application-Specific Definitions
+//----------------------------------------------------------------------------------------------------------
+#define EV_BUFFER_LENGTH			16		///< number of events that can be stored until they are read (must be a power of 2; one slot is always kept empty)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Types of the events that can be timestamped.
+ */
+enum EV_TYPE {EV_STATE = 0,			///< the main state machine entered a new state (parameter: member of \c BACKGROUND_STATES)
+			  EV_GAIN,				///< the gain stage changed (parameter: new gain stage)
+			  EV_TOUCH,				///< a touch of the QTouch key was detected (parameter: member of \c BACKGROUND_STATES that was active)
+			  EV_OVERRUN,			///< the EEG sample buffer overran (parameter: number of overruns since the last event, saturated at 255)
+			  EV_LEADOFF			///< the electrode contact state changed (parameter: member of \c LO_STATE)
+			 };
+
+/**
+ * Timestamped event.
+ */
+struct EV_EVENT {uint32_t	uintSampleIndex;	///< index of the EEG sample with which the event coincides (ev_stampAt()) or of the next EEG sample to be acquired (ev_stamp(); see avr_adc_getSampleIndex())
+				 uint8_t	type;				///< member of \c EV_TYPE
+				 uint8_t	uintParam;			///< type-dependent parameter
+				};
+
+//----------------------------------------------------------------------------------------------------------
+//   								Prototypes
+//----------------------------------------------------------------------------------------------------------
+void	ev_init(void);
+void	ev_stamp(enum EV_TYPE type, uint8_t uintParam);
+void	ev_stampAt(enum EV_TYPE type, uint8_t uintParam, uint32_t uintSampleIndex);
+BOOL	ev_get(struct EV_EVENT * pEvent);
+uint8_t	ev_getLost(void);
+
+#endif
@@ -21,50 +21,623 @@
 #include <stdint.h>
 
 #include "globals.h"
+#include "ring_buffer.h"
+#include "dsp.h"
+#include "drivers/avr_adc.h"
 #include "gain_adjust.h"
 #include "alarms.h"
 #include "drivers/pga112.h"
+#include "mains.h"
 
 //----------------------------------------------------------------------------------------------------------
 //   								Constants
 //----------------------------------------------------------------------------------------------------------
-static const uint8_t mc_uintPGAGains[GAINADJUST_NSTAGES] PROGMEM = {PGA112_G1,
-																    PGA112_G2,
-																    PGA112_G4,
-																    PGA112_G8};	///< array containing the digipot level associated with each gain level
+#define GA_BLOCK_LENGTH			ADC_EEG_BLOCK_LENGTH													///< number of samples summarized by one min/max pair of the sliding window
+#define GA_WINDOW_BLOCKS		((GAINADJUST_DATAWINDOW + GA_BLOCK_LENGTH - 1) / GA_BLOCK_LENGTH)	///< length of the sliding window (in blocks; \a GAINADJUST_DATAWINDOW rounded up to a whole number of blocks)
 
-static const uint8_t mc_uintEEGLimits[GAINADJUST_NSTAGES][2] PROGMEM = {{89, 44 },
-																	    {89, 44 },
-																	    {89, 44 },
-																	    {89, 44 }};
+#if (GA_WINDOW_BLOCKS > 255)
+#error "GAINADJUST_DATAWINDOW is too long for the 8-bit block counters"
+#endif
+
+#define GA_STAGES_1(M)			M(0)
+#define GA_STAGES_2(M)			GA_STAGES_1(M), M(1)
+#define GA_STAGES_3(M)			GA_STAGES_2(M), M(2)
+#define GA_STAGES_4(M)			GA_STAGES_3(M), M(3)
+#define GA_STAGES_5(M)			GA_STAGES_4(M), M(4)
+#define GA_STAGES_6(M)			GA_STAGES_5(M), M(5)
+#define GA_STAGES_7(M)			GA_STAGES_6(M), M(6)
+#define GA_STAGES_8(M)			GA_STAGES_7(M), M(7)
+#define GA_STAGES_CAT(n, M)		GA_STAGES_##n(M)
+#define GA_STAGES_N(n, M)		GA_STAGES_CAT(n, M)
+#define GA_STAGES(M)			GA_STAGES_N(GAINADJUST_NSTAGES, M)								///< expands to the initializer list M(0), M(1), ..., M(GAINADJUST_NSTAGES - 1)
+
+#define GA_FULLSCALE			((EEG_SAMPLE) ((1UL << ADC_EEG_RESOLUTION) - 1))					///< largest EEG sample value
+#define GA_CLIP_LOW				((EEG_SAMPLE) (GAINADJUST_CLIP_MARGIN << (ADC_EEG_RESOLUTION - 8)))	///< samples at or below this value are considered clipped
+#define GA_CLIP_HIGH			((EEG_SAMPLE) (GA_FULLSCALE - GA_CLIP_LOW))						///< samples at or above this value are considered clipped
+
+#ifdef GAINADJUST_TIMING
+#define GA_TIMING_BEGIN()		(PORTC |= (uint8_t) _BV(PC1))										///< marks the start of ga_processBlock() on PC1
+#define GA_TIMING_END()			(PORTC &= (uint8_t) ~_BV(PC1))									///< marks the end of ga_processBlock() on PC1
+#else
+#define GA_TIMING_BEGIN()		(PORTC ^= _BV(PC1))												///< marks the start of ga_processBlock() on PC1
+#define GA_TIMING_END()																			///< marks the end of ga_processBlock() on PC1
+#endif
+
+#if defined(GAINADJUST_HISTOGRAM) && defined(GAINADJUST_ENVELOPE)
+#error "GAINADJUST_HISTOGRAM and GAINADJUST_ENVELOPE cannot be used together"
+#elif !defined(GAINADJUST_HISTOGRAM) && !defined(GAINADJUST_ENVELOPE)
+#define GA_MINMAX																				///< defined if the P-P amplitude is measured between the window's min & max
+#endif
+
+#ifdef GAINADJUST_ENVELOPE
+#define GA_ENV_FRAC				(16 - ADC_EEG_RESOLUTION)										///< number of fractional bits of the baseline & envelope
+#define GA_ENV_SETTLE_BLOCKS	((3 << GAINADJUST_ENV_DC_SHIFT) / GA_BLOCK_LENGTH)				///< number of blocks after a reset during which the baseline settles and no gain decisions are taken
+
+#define GA_ENV_LAST_BLOCK		(GA_ENV_SETTLE_BLOCKS + GA_WINDOW_BLOCKS)						///< block at which a window of envelope values is complete
+
+#if (GA_ENV_SETTLE_BLOCKS < 2) || (GA_ENV_LAST_BLOCK > 255)
+#error "GAINADJUST_ENV_DC_SHIFT must give a settling time of at least 2 blocks and at most 255 blocks together with GAINADJUST_DATAWINDOW"
+#endif
+
+#if (GAINADJUST_ENV_ATTACK_SHIFT < 0) || (GAINADJUST_ENV_ATTACK_SHIFT > GAINADJUST_ENV_RELEASE_SHIFT) || (GAINADJUST_ENV_RELEASE_SHIFT > 8)
+#error "The envelope time constants must satisfy 0 <= GAINADJUST_ENV_ATTACK_SHIFT <= GAINADJUST_ENV_RELEASE_SHIFT <= 8"
+#endif
+#endif
+
+#ifdef GAINADJUST_DC_BLOCKER
+#define GA_DC_FRAC				(16 - ADC_EEG_RESOLUTION)										///< number of fractional bits of the DC blocker's baseline
+#define GA_DC_MID				((EEG_SAMPLE) ((GA_FULLSCALE + 1) / 2))							///< value around which the high-pass filtered samples are centred
+
+#ifdef GAINADJUST_ENVELOPE
+#error "GAINADJUST_DC_BLOCKER cannot be used with GAINADJUST_ENVELOPE (the envelope follower removes the baseline itself)"
+#endif
+
+#if (GAINADJUST_DC_SHIFT < 4) || (GAINADJUST_DC_SHIFT > 12)
+#error "GAINADJUST_DC_SHIFT must be between 4 and 12"
+#endif
+#endif
+
+#ifdef GAINADJUST_HISTOGRAM
+#define GA_HIST_BINS			(1 << GAINADJUST_HIST_BITS)										///< number of histogram bins
+#define GA_HIST_SHIFT			(ADC_EEG_RESOLUTION - GAINADJUST_HIST_BITS)						///< right shift that maps an EEG sample to its histogram bin
+
+#if (GAINADJUST_HIST_BITS < 1) || (GAINADJUST_HIST_BITS > 8) || (GAINADJUST_HIST_BITS > ADC_EEG_RESOLUTION)
+#error "GAINADJUST_HIST_BITS must be between 1 and min(8, ADC_EEG_RESOLUTION)"
+#endif
+
+#if (GAINADJUST_HIST_PERCENT < 0) || (GAINADJUST_HIST_PERCENT > 25)
+#error "GAINADJUST_HIST_PERCENT must be between 0 and 25"
+#endif
+#endif
+
+#define GA_LOG2(x)				((x) >= 128 ? 7 : (x) >= 64 ? 6 : (x) >= 32 ? 5 : (x) >= 16 ? 4 : (x) >= 8 ? 3 : (x) >= 4 ? 2 : (x) >= 2 ? 1 : 0)	///< base-2 logarithm of \a x (1 - 255, rounded down)
+
+#define GA_MV2COUNTS(mV)		((((uint32_t) (mV)) << ADC_EEG_RESOLUTION) / GAINADJUST_VREF_MV)	///< converts a voltage at the ADC input (in mV) to ADC counts at the resolution of the EEG samples
+#define GA_UPPER_COUNTS			((GAINADJUST_UPPER_MV << ADC_EEG_RESOLUTION) / GAINADJUST_VREF_MV)	///< upper P-P amplitude limit in ADC counts (preprocessor version of GA_MV2COUNTS())
+#define GA_LOWER_COUNTS			((GAINADJUST_LOWER_MV << ADC_EEG_RESOLUTION) / GAINADJUST_VREF_MV)	///< lower P-P amplitude limit in ADC counts (preprocessor version of GA_MV2COUNTS())
+
+#define GA_DISPSCALE_LOG2		GA_LOG2(GAINADJUST_DISPSCALE_UV / GAINADJUST_DISPPULSE_UV)		///< base-2 logarithm of the PGA gain required to display the lowest gain level
+
+#define GA_STAGE_GAIN(stage)	(PGA112_G1 + GAINADJUST_MIN_LOG2GAIN + (stage))					///< PGA setting of a gain level (the values of enum PGA112_GAINS are the base-2 logarithms of the gains)
+#define GA_STAGE_LIMITS(stage)	{(EEG_SAMPLE) GA_MV2COUNTS(GAINADJUST_UPPER_MV), (EEG_SAMPLE) GA_MV2COUNTS(GAINADJUST_LOWER_MV)}	///< upper & lower P-P amplitude limit of a gain level
+#define GA_DISPSCALE_GAIN(stage) (PGA112_G1 + GA_DISPSCALE_LOG2 + (stage))						///< PGA setting that produces the display scale signal of a gain level (i.e. GAINADJUST_DISPSCALE_UV << stage)
+
+//
+// static checks of the gain ladder
+//
+#if (GAINADJUST_NSTAGES < 1) || (GAINADJUST_NSTAGES > 8)
+#error "GAINADJUST_NSTAGES must be between 1 and 8"
+#endif
+
+#if (GAINADJUST_MIN_LOG2GAIN < 0) || (GAINADJUST_MIN_LOG2GAIN + GAINADJUST_NSTAGES > 8)
+#error "The gain ladder exceeds the gain range of the PGA112 (1 - 128)"
+#endif
+
+#if (GAINADJUST_INITIAL_STAGE < 0) || (GAINADJUST_INITIAL_STAGE >= GAINADJUST_NSTAGES)
+#error "GAINADJUST_INITIAL_STAGE must be a valid gain level (0 - GAINADJUST_NSTAGES - 1)"
+#endif
+
+#if (GAINADJUST_SETTLE_SAMPLES < 1) || (GAINADJUST_SETTLE_SAMPLES > 255)
+#error "GAINADJUST_SETTLE_SAMPLES must be between 1 and 255"
+#endif
+
+#if (GAINADJUST_UPPER_MV >= GAINADJUST_VREF_MV) || (GA_UPPER_COUNTS <= GA_LOWER_COUNTS) || (GA_LOWER_COUNTS == 0)
+#error "The P-P amplitude limits must be monotonic: 0 < GAINADJUST_LOWER_MV < GAINADJUST_UPPER_MV < GAINADJUST_VREF_MV"
+#endif
+
+#if (2 * GA_LOWER_COUNTS >= GA_UPPER_COUNTS)
+#error "Insufficient hysteresis: doubling the gain at the lower limit must yield an amplitude below the upper limit"
+#endif
+
+#if (GAINADJUST_CLIP_RUN < 1) || (GAINADJUST_CLIP_RUN > 255) || (GAINADJUST_CLIP_MARGIN >= 64)
+#error "GAINADJUST_CLIP_RUN must be between 1 and 255 and GAINADJUST_CLIP_MARGIN below 64"
+#endif
+
+#if ((GAINADJUST_DISPPULSE_UV << GA_DISPSCALE_LOG2) != GAINADJUST_DISPSCALE_UV)
+#error "GAINADJUST_DISPSCALE_UV must be GAINADJUST_DISPPULSE_UV times a power of 2"
+#endif
+
+#if (GA_DISPSCALE_LOG2 + GAINADJUST_NSTAGES > 8)
+#error "The display scale signal of the highest gain level exceeds the gain range of the PGA112"
+#endif
+
+static const uint8_t mc_uintPGAGains[GAINADJUST_NSTAGES] PROGMEM = {GA_STAGES(GA_STAGE_GAIN)};			///< PGA setting of each gain level
+
+static const EEG_SAMPLE mc_uintEEGLimits[GAINADJUST_NSTAGES][2] PROGMEM = {GA_STAGES(GA_STAGE_LIMITS)};	///< upper & lower P-P amplitude limits of each gain level (in ADC counts)
+
+static const uint8_t mc_uintDisplayScaleGains[GAINADJUST_NSTAGES] PROGMEM = {GA_STAGES(GA_DISPSCALE_GAIN)};	///< PGA setting used during Display Scale for each gain level
 
 //----------------------------------------------------------------------------------------------------------
 //   								Variables
 //----------------------------------------------------------------------------------------------------------
-static BOOL				m_blnWaitStateComplete;							///< 
-static enum GA_STATE	m_gasCurrentState;								///< 
+#if defined(GAINADJUST_HISTOGRAM)
+static uint16_t			m_uintHistogram[GA_HIST_BINS];					///< number of samples of the current window in each bin
+#elif defined(GAINADJUST_ENVELOPE)
+static uint16_t			m_uintBaseline;									///< baseline (DC level) of the signal (\a GA_ENV_FRAC fractional bits)
+static uint16_t			m_uintPeak;										///< largest rectified sample of the current block (\a GA_ENV_FRAC fractional bits)
+static uint16_t			m_uintEnvelope;									///< envelope of the rectified signal (\a GA_ENV_FRAC fractional bits)
+static uint16_t			m_uintEnvelopeMax;								///< largest envelope of the current window (\a GA_ENV_FRAC fractional bits)
+#else
+static EEG_SAMPLE		m_uintBlockMax[GA_WINDOW_BLOCKS];				///< largest sample of each block in the sliding window (ring buffer)
+static EEG_SAMPLE		m_uintBlockMin[GA_WINDOW_BLOCKS];				///< smallest sample of each block in the sliding window (ring buffer)
+static uint8_t			m_uintBlockPos;									///< slot of \a m_uintBlockMax & \a m_uintBlockMin in which the next block is stored
+#endif
+#ifdef GAINADJUST_DC_BLOCKER
+static uint16_t			m_uintDCBaseline;								///< baseline removed from the samples before the amplitude estimation (\a GA_DC_FRAC fractional bits)
+#endif
+static uint8_t			m_uintWindowBlocks;								///< number of blocks in the window (less than \a GA_WINDOW_BLOCKS after a reset or gain change)
+
+static uint8_t			m_uintSettleCounter;							///< number of samples that are still to be ignored after a reset
+static uint8_t			m_uintSampleCounter;							///< amount of samples of the current block gathered so far
+#ifdef GA_MINMAX
+static EEG_SAMPLE		m_uintLocalMax;									///< largest sample of the current block
+static EEG_SAMPLE		m_uintLocalMin;									///< smallest sample of the current block
+#endif
 
-static uint16_t			m_uintSampleCounter;							///< amount of samples gathered so far
-static uint8_t			m_uintLocalMax;									///< 
-static uint8_t			m_uintLocalMin;									///< 
+static uint8_t			m_uintClipRun;									///< number of consecutive clipped samples (saturates at \a GAINADJUST_CLIP_RUN)
 
 static uint8_t			m_uintGainStage;								///< current adapter gain level
 
+#ifdef GAINADJUST_QUALITY
+RB_DEFINE(quality, struct GA_QUALITY, GAINADJUST_QUALITY_RECORDS)	// buffer in which the quality records are stored until they are read
+
+static uint8_t			m_uintQualityBlocks;							///< number of blocks in the current quality window
+static uint16_t			m_uintQualitySamples;							///< number of samples in the current quality window
+static uint32_t			m_uintQualitySum;								///< sum of the samples of the current quality window
+static uint32_t			m_uintQualityDeviation;							///< sum of the absolute deviations from \a m_uintQualityMean
+static EEG_SAMPLE		m_uintQualityMax;								///< largest sample of the current quality window
+static EEG_SAMPLE		m_uintQualityMin;								///< smallest sample of the current quality window
+static EEG_SAMPLE		m_uintQualityMean;								///< mean of the previous quality window
+static uint16_t			m_uintQualityClipped;							///< number of clipped samples of the current quality window
+static uint16_t			m_uintQualityCrossings;							///< number of crossings of \a m_uintQualityMean in the current quality window
+static BOOL				m_blnQualityAbove;								///< flag indicating that the last sample was at or above \a m_uintQualityMean
+#endif
+
+#ifdef GAINADJUST_STATISTICS
+static struct GA_STATISTICS	m_Statistics;							///< statistics of the gain controller
+static uint8_t			m_uintLastDirection;							///< direction of the most recent gain change (0 = none, 1 = increase, 2 = decrease)
+#endif
+
+//----------------------------------------------------------------------------------------------------------
+//   								Static Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Computes the gain level at which the measured P-P amplitude would be within the limits.
+ *
+ * \details		The amplitude at another gain level is predicted by scaling the measured one with the ratio of the
+ *				two gains (each gain level doubles the gain of the previous one):\n
+ *				- if the amplitude is at or above the upper limit, the highest lower gain level at which the predicted
+ *				  amplitude is below that level's upper limit is chosen (or the lowest gain level)\n
+ *				- if the window is full and the amplitude is at or below the lower limit, the highest gain level at
+ *				  which the predicted amplitude stays below that level's upper limit is chosen
+ *
+ *				If the amplitude is only known within a range, the gain is decreased based on the lower bound and
+ *				increased based on the upper bound, so the hysteresis between the limits is not reduced.
+ *
+ * \param[in]	uintAmpLow			P-P amplitude measured at the current gain level (lower bound)
+ * \param[in]	uintAmpHigh			P-P amplitude measured at the current gain level (upper bound)
+ * \param[in]	blnFullWindow		indicates whether the amplitude was measured over a full window
+ *
+ * \return		target gain level (equal to the current one if no change is required)
+ */
+static uint8_t ga_targetStage(const EEG_SAMPLE uintAmpLow, const EEG_SAMPLE uintAmpHigh, const BOOL blnFullWindow)
+{
+	uint8_t uintTarget = m_uintGainStage;
+
+	if(uintAmpLow >= PGM_READ_EEG_SAMPLE(&mc_uintEEGLimits[m_uintGainStage][0]))
+	{
+		// amplitude too large: decrease the gain until the predicted amplitude is below the upper limit
+		while(uintTarget > 0)
+		{
+			uintTarget--;
+			if((uintAmpLow >> (m_uintGainStage - uintTarget)) < PGM_READ_EEG_SAMPLE(&mc_uintEEGLimits[uintTarget][0]))
+				break;
+		}
+	}
+	else if(blnFullWindow && (uintAmpHigh <= PGM_READ_EEG_SAMPLE(&mc_uintEEGLimits[m_uintGainStage][1])))
+	{
+		// amplitude too small: increase the gain as long as the predicted amplitude stays below the upper limit
+		// (the loop stops at the first predicted amplitude above the limit, so the shift cannot overflow 16 bits)
+		while((uintTarget < (GAINADJUST_NSTAGES - 1)) &&
+			  (((uint16_t) uintAmpHigh << (uintTarget + 1 - m_uintGainStage)) < PGM_READ_EEG_SAMPLE(&mc_uintEEGLimits[uintTarget + 1][0])))
+		{
+			uintTarget++;
+		}
+	}
+
+	return uintTarget;
+}
+
+#ifdef GAINADJUST_MAINS
+/**
+ * \brief		Removes the mains interference from a measured P-P amplitude.
+ *
+ * \details		The amplitude of the mains interference is subtracted from both bounds. The upper bound (on which
+ *				gain increases are based) is kept above the measured amplitude scaled by the ratio between the upper
+ *				limit and the span between the clipping thresholds, so that the gain is never increased to a level at
+ *				which the mains interference itself would clip.
+ *
+ * \param[in,out]	puintAmpLow		P-P amplitude measured at the current gain level (lower bound)
+ * \param[in,out]	puintAmpHigh	P-P amplitude measured at the current gain level (upper bound)
+ */
+static void ga_removeMains(EEG_SAMPLE * puintAmpLow, EEG_SAMPLE * puintAmpHigh)
+{
+	EEG_SAMPLE uintMains = mn_getAmplitude();
+	EEG_SAMPLE uintFloor = (EEG_SAMPLE) (((uint32_t) *puintAmpHigh * GA_UPPER_COUNTS) / (GA_CLIP_HIGH - GA_CLIP_LOW));
+
+	*puintAmpLow = (*puintAmpLow > uintMains) ? *puintAmpLow - uintMains : 0;
+	*puintAmpHigh = (*puintAmpHigh > uintMains) ? *puintAmpHigh - uintMains : 0;
+	if(*puintAmpHigh < uintFloor)
+		*puintAmpHigh = uintFloor;
+}
+#endif
+
+#ifdef GAINADJUST_HISTOGRAM
+/**
+ * \brief		Measures the P-P amplitude of the current window between two percentiles of its histogram.
+ *
+ * \details		The lowest & highest \a GAINADJUST_HIST_PERCENT percent of the window's samples are ignored (at least
+ *				one sample at each end), so single outliers such as electrode pops do not affect the amplitude. Since
+ *				only the bins of the two percentiles are known, the amplitude is returned as a range.
+ *
+ * \param[out]	puintAmpLow			lower bound of the P-P amplitude
+ * \param[out]	puintAmpHigh		upper bound of the P-P amplitude
+ */
+static void ga_histogramAmplitude(EEG_SAMPLE * puintAmpLow, EEG_SAMPLE * puintAmpHigh)
+{
+	uint16_t uintTrim, uintSum;
+	uint8_t uintLo, uintHi, uintSpan;
+
+	uintTrim = (uint16_t) (((uint16_t) m_uintWindowBlocks * GA_BLOCK_LENGTH * GAINADJUST_HIST_PERCENT + 99) / 100);
+
+	// bin of the lower percentile
+	uintSum = 0;
+	for(uintLo = 0; uintLo < GA_HIST_BINS - 1; uintLo++)
+	{
+		uintSum += m_uintHistogram[uintLo];
+		if(uintSum > uintTrim)
+			break;
+	}
+
+	// bin of the upper percentile
+	uintSum = 0;
+	for(uintHi = GA_HIST_BINS - 1; uintHi > uintLo; uintHi--)
+	{
+		uintSum += m_uintHistogram[uintHi];
+		if(uintSum > uintTrim)
+			break;
+	}
+
+	uintSpan = (uint8_t) (uintHi - uintLo);
+	*puintAmpLow = uintSpan ? (EEG_SAMPLE) ((((uint16_t) uintSpan - 1) << GA_HIST_SHIFT) + 1) : 0;
+	*puintAmpHigh = (EEG_SAMPLE) ((((uint16_t) uintSpan + 1) << GA_HIST_SHIFT) - 1);
+}
+#endif
+
+#ifdef GAINADJUST_QUALITY
+/**
+ * \brief		Stores the quality record of the current quality window and starts a new one.
+ *
+ * \param[in]	uintFlags		additional flags of the record (see \c GA_QUALITY_FLAGS)
+ */
+static void ga_closeQuality(uint8_t uintFlags)
+{
+	struct GA_QUALITY quality;
+
+	if(m_uintQualitySamples)
+	{
+		quality.uintPeakToPeak = m_uintQualityMax - m_uintQualityMin;
+		quality.uintMean = (EEG_SAMPLE) (m_uintQualitySum / m_uintQualitySamples);
+		quality.uintDeviation = (EEG_SAMPLE) (m_uintQualityDeviation / m_uintQualitySamples);
+		quality.uintClipped = m_uintQualityClipped;
+		quality.uintCrossings = m_uintQualityCrossings;
+		quality.uintGainStage = m_uintGainStage;
+
+		if(m_uintQualityClipped)
+			uintFlags |= GA_Q_CLIPPED;
+		if(((uint32_t) quality.uintDeviation << GAINADJUST_QUALITY_CREST_SHIFT) < quality.uintPeakToPeak)
+			uintFlags |= GA_Q_ARTIFACT;
+		quality.uintFlags = uintFlags;
+
+		// the record is lost if the buffer is full
+		rb_quality_put(quality);
+
+		// the deviation & crossings of the next window are measured against this mean (unless the window was
+		// too short to give a reliable mean)
+		if(!(uintFlags & GA_Q_GAINCHANGE))
+			m_uintQualityMean = quality.uintMean;
+	}
+
+	m_uintQualityBlocks = 0;
+	m_uintQualitySamples = 0;
+	m_uintQualitySum = 0;
+	m_uintQualityDeviation = 0;
+	m_uintQualityClipped = 0;
+	m_uintQualityCrossings = 0;
+}
+#endif
+
+/**
+ * \brief		Switches to a new gain level.
+ *
+ * \details		After a gain change the sliding window is emptied, since its samples were acquired with the previous
+ *				gain.
+ *
+ * \param[in]	uintTarget			new gain level
+ *
+ * \return		TRUE if the gain level was changed, FALSE if \a uintTarget is the current gain level
+ */
+static BOOL ga_setStage(const uint8_t uintTarget)
+{
+#ifdef GAINADJUST_DC_BLOCKER
+	int32_t intOffset;
+
+#endif
+	if(uintTarget == m_uintGainStage)
+		return FALSE;
+
+#ifdef GAINADJUST_ENVELOPE
+	// predict the envelope at the new gain level
+	if(uintTarget < m_uintGainStage)
+		m_uintEnvelope >>= (m_uintGainStage - uintTarget);
+	else
+		m_uintEnvelope <<= (uintTarget - m_uintGainStage);
+#endif
+
+#ifdef GAINADJUST_STATISTICS
+	if(uintTarget > m_uintGainStage)
+	{
+		if(m_Statistics.uintIncreases < 0xFFFF)
+			m_Statistics.uintIncreases++;
+		if((m_uintLastDirection == 2) && (m_Statistics.uintReversals < 0xFFFF))
+			m_Statistics.uintReversals++;
+		m_uintLastDirection = 1;
+	}
+	else
+	{
+		if(m_Statistics.uintDecreases < 0xFFFF)
+			m_Statistics.uintDecreases++;
+		if((m_uintLastDirection == 1) && (m_Statistics.uintReversals < 0xFFFF))
+			m_Statistics.uintReversals++;
+		m_uintLastDirection = 2;
+	}
+	m_Statistics.uintLastChange = m_Statistics.uintSamples;
+#endif
+
+#ifdef GAINADJUST_DC_BLOCKER
+	// predict the baseline at the new gain level (assuming that the front end amplifies around mid-scale; otherwise
+	// the DC blocker settles within a few time constants)
+	intOffset = (int32_t) m_uintDCBaseline - ((uint16_t) GA_DC_MID << GA_DC_FRAC);
+	if(uintTarget < m_uintGainStage)
+		intOffset >>= (m_uintGainStage - uintTarget);
+	else
+		intOffset *= (int16_t) (1 << (uintTarget - m_uintGainStage));
+	if(intOffset > (int32_t) ((uint16_t) GA_DC_MID << GA_DC_FRAC) - 1)
+		intOffset = (int32_t) ((uint16_t) GA_DC_MID << GA_DC_FRAC) - 1;
+	else if(intOffset < -(int32_t) ((uint16_t) GA_DC_MID << GA_DC_FRAC))
+		intOffset = -(int32_t) ((uint16_t) GA_DC_MID << GA_DC_FRAC);
+	m_uintDCBaseline = (uint16_t) (intOffset + ((uint16_t) GA_DC_MID << GA_DC_FRAC));
+#endif
+
+#ifdef GAINADJUST_QUALITY
+	// the quality record must not mix two gain levels
+	ga_closeQuality(GA_Q_GAINCHANGE);
+#endif
+
+#ifdef GAINADJUST_MAINS
+	// the mains interference scales with the gain
+	mn_scale((int8_t) (uintTarget - m_uintGainStage));
+#endif
+
+	// the PGA is written by the ADC ISR right after the next EEG conversion
+	m_uintGainStage = uintTarget;
+	pga112_queueGain(pgm_read_byte(&mc_uintPGAGains[m_uintGainStage]));
+	ga_reset();
+
+#ifdef DEBUGGING
+	alarms_set_gain(m_uintGainStage);
+#endif
+
+	return TRUE;
+}
+
+/**
+ * \brief		Closes the current block of the window and, if neccessary, changes the gain level.
+ *
+ * \details		The P-P amplitude is estimated over a window of the last \a GA_WINDOW_BLOCKS blocks of
+ *				\a GA_BLOCK_LENGTH samples that slides by one block at a time: the min & max of every block are kept
+ *				in a ring buffer, so the window's min & max are updated once per block with 2 * \a GA_WINDOW_BLOCKS
+ *				comparisons (a few comparisons per sample, independently of the position in the window).\n
+ *				The gain is decreased as soon as the P-P amplitude of the (possibly partially filled) window reaches
+ *				the upper limit, and increased once the P-P amplitude of a full window is at or below the lower limit.
+ *				The new gain level is computed from the amplitude (see ga_targetStage()), so the gain can jump by
+ *				several levels with a single PGA write. After a gain change the window is emptied, since its samples
+ *				were acquired with the previous gain.\n
+ *				If \a GAINADJUST_HISTOGRAM is defined, a histogram of the window's samples is kept instead of the
+ *				block min & max, and the amplitude is measured between two percentiles (see ga_histogramAmplitude()).
+ *				A histogram cannot forget old samples, so the window does not slide but is emptied after every full
+ *				window.\n
+ *				If \a GAINADJUST_ENVELOPE is defined, the baseline is removed from every sample with a first-order
+ *				high-pass filter, and the largest rectified sample of each block drives an envelope follower that rises
+ *				with the attack and falls with the release time constant. Twice the envelope is used as P-P amplitude.
+ *				All filters use shifts only. No decisions are taken while the baseline settles after a reset. The gain
+ *				is decreased as soon as the envelope reaches the upper limit, but only increased if the largest envelope
+ *				of a whole window (raised by \a GAINADJUST_ENV_MARGIN_SHIFT) is at or below the lower limit; otherwise
+ *				the release would let the gain oscillate around signals whose amplitude lies close to the limits. On a
+ *				gain change the envelope is scaled by the gain ratio.\n
+ *				If \a GAINADJUST_MAINS is defined, the mains interference is removed from the amplitude before the
+ *				decision (see ga_removeMains()).
+ *
+ * \return		TRUE if the gain level was changed, FALSE otherwise
+ */
+static BOOL ga_closeBlock(void)
+{
+#ifdef GAINADJUST_HISTOGRAM
+	EEG_SAMPLE uintAmpLow, uintAmpHigh;
+
+	if(m_uintWindowBlocks < GA_WINDOW_BLOCKS)
+		m_uintWindowBlocks++;
+
+	//
+	// increase or decrease the gain depending on the P-P amplitude
+	//
+	ga_histogramAmplitude(&uintAmpLow, &uintAmpHigh);
+#ifdef GAINADJUST_MAINS
+	ga_removeMains(&uintAmpLow, &uintAmpHigh);
+#endif
+	if(ga_setStage(ga_targetStage(uintAmpLow, uintAmpHigh, m_uintWindowBlocks == GA_WINDOW_BLOCKS)))
+		return TRUE;
+
+	// start a new window
+	if(m_uintWindowBlocks == GA_WINDOW_BLOCKS)
+		ga_reset();
+
+	return FALSE;
+#elif defined(GAINADJUST_ENVELOPE)
+	uint16_t uintAmpLow, uintAmpHigh;
+	EEG_SAMPLE uintWindowLow, uintWindowHigh;
+
+	if(m_uintWindowBlocks < GA_ENV_LAST_BLOCK)
+		m_uintWindowBlocks++;
+
+	//
+	// envelope (skipped during the first half of the settling time, while the baseline error is large)
+	//
+	if(m_uintWindowBlocks > GA_ENV_SETTLE_BLOCKS / 2)
+	{
+		m_uintEnvelope = dsp_trackU16(m_uintEnvelope, m_uintPeak, GAINADJUST_ENV_ATTACK_SHIFT, GAINADJUST_ENV_RELEASE_SHIFT);
+	}
+	m_uintPeak = 0;
+
+	if(m_uintWindowBlocks < GA_ENV_SETTLE_BLOCKS)
+		return FALSE;
+	if((m_uintWindowBlocks == GA_ENV_SETTLE_BLOCKS) || (m_uintEnvelope > m_uintEnvelopeMax))
+		m_uintEnvelopeMax = m_uintEnvelope;
+
+	//
+	// increase or decrease the gain depending on the P-P amplitude (= 2 * envelope)
+	//
+	uintAmpLow = m_uintEnvelope >> (GA_ENV_FRAC - 1);
+	if(uintAmpLow > GA_FULLSCALE)
+		uintAmpLow = GA_FULLSCALE;
+	uintAmpHigh = m_uintEnvelopeMax >> (GA_ENV_FRAC - 1);
+	uintAmpHigh += uintAmpHigh >> GAINADJUST_ENV_MARGIN_SHIFT;
+	if(uintAmpHigh > GA_FULLSCALE)
+		uintAmpHigh = GA_FULLSCALE;
+
+	uintWindowLow = (EEG_SAMPLE) uintAmpLow;
+	uintWindowHigh = (EEG_SAMPLE) uintAmpHigh;
+#ifdef GAINADJUST_MAINS
+	ga_removeMains(&uintWindowLow, &uintWindowHigh);
+#endif
+	if(ga_setStage(ga_targetStage(uintWindowLow, uintWindowHigh, m_uintWindowBlocks == GA_ENV_LAST_BLOCK)))
+		return TRUE;
+
+	// start a new window
+	if(m_uintWindowBlocks == GA_ENV_LAST_BLOCK)
+	{
+		m_uintWindowBlocks = GA_ENV_SETTLE_BLOCKS;
+		m_uintEnvelopeMax = m_uintEnvelope;
+	}
+
+	return FALSE;
+#else
+	EEG_SAMPLE uintWindowMax, uintWindowMin, uintAmpLow, uintAmpHigh;
+	uint8_t i;
+
+	//
+	// slide the window by one block
+	//
+	m_uintBlockMax[m_uintBlockPos] = m_uintLocalMax;
+	m_uintBlockMin[m_uintBlockPos] = m_uintLocalMin;
+	if(++m_uintBlockPos == GA_WINDOW_BLOCKS)
+		m_uintBlockPos = 0;
+	if(m_uintWindowBlocks < GA_WINDOW_BLOCKS)
+		m_uintWindowBlocks++;
+
+	// compute P-P amplitude of the window (slots 0 .. m_uintWindowBlocks - 1 are in use, since the window is
+	// always filled starting from slot 0)
+	uintWindowMax = m_uintBlockMax[0];
+	uintWindowMin = m_uintBlockMin[0];
+	for(i = 1; i < m_uintWindowBlocks; i++)
+	{
+		if(m_uintBlockMax[i] > uintWindowMax)
+			uintWindowMax = m_uintBlockMax[i];
+		if(m_uintBlockMin[i] < uintWindowMin)
+			uintWindowMin = m_uintBlockMin[i];
+	}
+
+	//
+	// increase or decrease the gain depending on the P-P amplitude
+	//
+	uintAmpLow = uintAmpHigh = uintWindowMax - uintWindowMin;
+#ifdef GAINADJUST_MAINS
+	ga_removeMains(&uintAmpLow, &uintAmpHigh);
+#endif
+	return ga_setStage(ga_targetStage(uintAmpLow, uintAmpHigh, m_uintWindowBlocks == GA_WINDOW_BLOCKS));
+#endif
+}
+
 //----------------------------------------------------------------------------------------------------------
 //   								Code
 //----------------------------------------------------------------------------------------------------------
 /**
  * \brief		Initializes the gain adjustment module.
  *
- * \details		Initializes all of the module's global variables and sets the digipot to the level corresponding
- *			    to the maximum gain level. 
+ * \details		Initializes all of the module's global variables and sets the PGA to the gain level
+ *				\a GAINADJUST_INITIAL_STAGE.
  *
  * \note		This function must be called before any other function in this module.
  */
 void ga_init(void)
 {
-	m_uintGainStage = GAINADJUST_NSTAGES - 1;
+	m_uintGainStage = GAINADJUST_INITIAL_STAGE;
+#ifdef GAINADJUST_ENVELOPE
+	m_uintEnvelope = 0;
+#endif
+#ifdef GAINADJUST_DC_BLOCKER
+	m_uintDCBaseline = (uint16_t) GA_DC_MID << GA_DC_FRAC;
+#endif
+#ifdef GAINADJUST_QUALITY
+	rb_quality_init();
+	m_uintQualitySamples = 0;
+	m_uintQualityMean = (EEG_SAMPLE) ((1UL << ADC_EEG_RESOLUTION) / 2);
+	ga_closeQuality(0);
+#endif
+#ifdef GAINADJUST_MAINS
+	mn_init();
+#endif
 	ga_reset();
+#ifdef GAINADJUST_STATISTICS
+	m_Statistics.uintSamples = 0;
+	m_Statistics.uintLastChange = 0;
+	m_Statistics.uintClippedSamples = 0;
+	m_Statistics.uintIncreases = 0;
+	m_Statistics.uintDecreases = 0;
+	m_Statistics.uintClipDecreases = 0;
+	m_Statistics.uintReversals = 0;
+	m_uintLastDirection = 0;
+#endif
 	
 	pga112_init();
 	pga112_setChannel(PGA112_CH1);
@@ -76,150 +649,345 @@ void ga_init(void)
 }
 
 /**
- * \brief		Resets the sample counter variables.
+ * \brief		Empties the window.
+ *
+ * \details		With \a GAINADJUST_ENVELOPE the envelope is kept, but the baseline is restarted from the next sample.
  */
 void ga_reset(void)
 {
-	m_gasCurrentState = GA_GATHERANLYZE1;
+#if defined(GAINADJUST_HISTOGRAM)
+	uint16_t i;
+
+	for(i = 0; i < GA_HIST_BINS; i++)
+		m_uintHistogram[i] = 0;
+#elif defined(GAINADJUST_ENVELOPE)
+	m_uintPeak = 0;
+#else
+	m_uintBlockPos = 0;
+#endif
+	m_uintSettleCounter = GAINADJUST_SETTLE_SAMPLES;
+	m_uintSampleCounter = 0;
+	m_uintWindowBlocks = 0;
+	m_uintClipRun = 0;
+#ifdef GAINADJUST_MAINS
+	mn_reset();
+#endif
 }
 
 /**
- * \brief		Handles new signal samples and, if neccessary, changes the gain level after \a GAINADJUST_INTERVAL samples have been gathered.
+ * \brief		Handles a new signal sample and, if neccessary, changes the gain level.
+ *
+ * \details		Same as ga_processBlock() for a single sample.
  *
- * \param[in]	uintSample	new signal sample
+ * \param[in]	uintNewSample	new signal sample
  *
- * \return		a member of the \c GA_STATE enumeration
+ * \return		TRUE if the gain level was changed, FALSE otherwise
  */
-BOOL ga_newsample(const uint8_t uintNewSample)
+BOOL ga_newsample(const EEG_SAMPLE uintNewSample)
 {
-	BOOL blnReturnValue = FALSE;
-	uint8_t uintAmpPP;
-	
-	PORTC ^= _BV(PC1);
+	uint8_t uintIndex;
 
-	switch(m_gasCurrentState)
-	{
-		case GA_GATHERANLYZE1:
-			m_blnWaitStateComplete = FALSE;
-			m_uintSampleCounter = 1;
+	return ga_processBlock(&uintNewSample, 1, &uintIndex);
+}
 
-			// initialize local min & max variables
-			m_uintLocalMax = m_uintLocalMin = uintNewSample;
+/**
+ * \brief		Handles a block of new signal samples and, if neccessary, changes the gain level.
+ *
+ * \details		The samples are processed in runs that end at the block boundaries of the window, so the per-sample
+ *				work is limited to the clipping check and the min & max (or histogram) update, with the module's
+ *				variables held in registers; the P-P amplitude is only evaluated when a block is complete (see
+ *				ga_closeBlock()).\n
+ *				In addition, \a GAINADJUST_CLIP_RUN consecutive samples within \a GAINADJUST_CLIP_MARGIN of either ADC
+ *				rail decrease the gain immediately (fast attack). A clipped signal spans at least the full ADC range,
+ *				so the gain level is chosen as if the P-P amplitude were full scale. This also catches a signal that
+ *				is pinned to one rail by an offset, whose P-P amplitude is small.\n
+ *				Processing stops at the sample that caused a gain change, since the following samples were acquired
+ *				with the previous gain. After a reset, the first \a GAINADJUST_SETTLE_SAMPLES samples are skipped, so
+ *				the transients of the preceding gain or switch change don't enter the estimate.\n
+ *				PC1 is toggled at each call. With \a GAINADJUST_TIMING defined it is high while the function runs, so the
+ *				cycles per call are the pulse width on an oscilloscope times F_CPU (the state transition of Timer/Counter1
+ *				also toggles PC1, once per state change interval). To compare the block with the per-sample processing,
+ *				measure the pulse once per block of \a ADC_EEG_BLOCK_LENGTH samples as the Recording state calls it, and
+ *				once with the call replaced by a loop of ga_newsample() over the same block, summing its 32 pulses. The
+ *				expected costs of the default min/max estimator (8-bit samples, estimated from the instruction counts of
+ *				gcc -Os code, to be confirmed on the device) are approx. 15 cycles per sample plus approx. 100 cycles per
+ *				call, i.e. approx. 600 cycles (150 us at 4 MHz, 19 cycles per sample) per block against approx. 3700
+ *				cycles (115 cycles per sample) for 32 calls of ga_newsample(), or approx. 1 % against 7 % of the 1600
+ *				cycles of a sampling period. Both include ga_closeBlock() once per block (approx. 100 - 200 cycles,
+ *				more if the gain is changed).
+ *
+ * \param[in]	puintSamples	new signal samples
+ * \param[in]	uintCount		number of samples
+ * \param[out]	puintIndex		index of the sample at which the gain level was changed (only valid if TRUE is returned)
+ *
+ * \return		TRUE if the gain level was changed, FALSE otherwise
+ */
+BOOL ga_processBlock(const EEG_SAMPLE * puintSamples, uint8_t uintCount, uint8_t * puintIndex)
+{
+	const EEG_SAMPLE * puintStart = puintSamples;
+	const EEG_SAMPLE * puintEnd;
+	EEG_SAMPLE uintSample;
+	uint8_t uintRun, uintClipRun;
+	BOOL blnClipAttack = FALSE;
+#if defined(GAINADJUST_ENVELOPE)
+	uint16_t uintBaseline, uintPeak, uintRect;
+#elif defined(GA_MINMAX)
+	EEG_SAMPLE uintMax, uintMin;
+#endif
+#ifdef GAINADJUST_DC_BLOCKER
+	uint16_t uintDCBaseline, uintShifted;
+#endif
+#ifdef GAINADJUST_QUALITY
+	uint32_t uintQualitySum, uintQualityDeviation;
+	EEG_SAMPLE uintQualityMax, uintQualityMin, uintQualityMean;
+	uint16_t uintQualityClipped, uintQualityCrossings;
+	BOOL blnQualityAbove;
+#endif
 
-			// set next state
-			m_gasCurrentState = GA_GATHERANLYZE2;
-		break;
+	GA_TIMING_BEGIN();
 
-		case GA_GATHERANLYZE2:
-			m_uintSampleCounter++;
+#ifdef GAINADJUST_STATISTICS
+	// counted once per call, so the convergence time is resolved to the length of the processed blocks
+	m_Statistics.uintSamples += uintCount;
+#endif
 
-			// check if sample represents new local min/max
-			if(uintNewSample > m_uintLocalMax)
-				m_uintLocalMax = uintNewSample;
-			else if(uintNewSample < m_uintLocalMin)
-				m_uintLocalMin = uintNewSample;
+	// samples acquired while the front end settles
+	if(m_uintSettleCounter)
+	{
+		uintRun = (m_uintSettleCounter < uintCount) ? m_uintSettleCounter : uintCount;
+		m_uintSettleCounter -= uintRun;
+		uintCount -= uintRun;
+		puintSamples += uintRun;
+	}
 
-			// perform analysis if gathered enough data samples
-			if(m_uintSampleCounter == GAINADJUST_DATAWINDOW)
-			{
-				// compute P-P amplitude
-				uintAmpPP = m_uintLocalMax - m_uintLocalMin;
+	uintClipRun = m_uintClipRun;
+	while(uintCount)
+	{
+		// samples up to the end of the current block
+		uintRun = (uint8_t) (GA_BLOCK_LENGTH - m_uintSampleCounter);
+		if(uintRun > uintCount)
+			uintRun = uintCount;
+		uintCount -= uintRun;
+		m_uintSampleCounter += uintRun;
+		puintEnd = puintSamples + uintRun;
 
-				// increase or decrease the gain depending on the P-P amplitude
-				if(uintAmpPP <= pgm_read_byte(&mc_uintEEGLimits[m_uintGainStage][1]) && 
-				   m_uintGainStage < (GAINADJUST_NSTAGES - 1))
-				{
-					// adjust gain state variable
-					m_uintGainStage++;
+#if defined(GAINADJUST_ENVELOPE)
+		if((m_uintSampleCounter == uintRun) && (m_uintWindowBlocks == 0))
+			uintBaseline = (uint16_t) *puintSamples << GA_ENV_FRAC;
+		else
+			uintBaseline = m_uintBaseline;
+		uintPeak = m_uintPeak;
+#elif defined(GA_MINMAX)
+		if(m_uintSampleCounter == uintRun)
+#ifdef GAINADJUST_DC_BLOCKER
+			uintMax = uintMin = GA_DC_MID;			// the baseline lies within the range of the window's samples
+#else
+			uintMax = uintMin = *puintSamples;
+#endif
+		else
+		{
+			uintMax = m_uintLocalMax;
+			uintMin = m_uintLocalMin;
+		}
+#endif
+#ifdef GAINADJUST_DC_BLOCKER
+		uintDCBaseline = m_uintDCBaseline;
+#endif
+#ifdef GAINADJUST_QUALITY
+		if(m_uintQualitySamples == 0)
+			m_uintQualityMax = m_uintQualityMin = *puintSamples;
+		uintQualitySum = m_uintQualitySum;
+		uintQualityDeviation = m_uintQualityDeviation;
+		uintQualityMax = m_uintQualityMax;
+		uintQualityMin = m_uintQualityMin;
+		uintQualityMean = m_uintQualityMean;
+		uintQualityClipped = m_uintQualityClipped;
+		uintQualityCrossings = m_uintQualityCrossings;
+		blnQualityAbove = m_blnQualityAbove;
+#endif
 
-					// change gain
-					pga112_setGain(pgm_read_byte(&mc_uintPGAGains[m_uintGainStage]));
+		while(puintSamples != puintEnd)
+		{
+			uintSample = *puintSamples++;
 
-					// set next state & fcn return value
-					m_gasCurrentState = GA_GATHERANLYZE1;
-					blnReturnValue = TRUE;
-				}
-				else if(uintAmpPP >= pgm_read_byte(&mc_uintEEGLimits[m_uintGainStage][0]) && 
-						m_uintGainStage > 0)
+			// rail clipping
+			if((uintSample <= GA_CLIP_LOW) || (uintSample >= GA_CLIP_HIGH))
+			{
+#ifdef GAINADJUST_STATISTICS
+				m_Statistics.uintClippedSamples++;
+#endif
+#ifdef GAINADJUST_QUALITY
+				uintQualityClipped++;
+#endif
+				if(uintClipRun < GAINADJUST_CLIP_RUN)
+					uintClipRun++;
+				if((uintClipRun == GAINADJUST_CLIP_RUN) && (ga_targetStage(GA_FULLSCALE, GA_FULLSCALE, FALSE) != m_uintGainStage))
 				{
-					if(m_blnWaitStateComplete)
-					{
-						// adjust gain state variable
-						m_uintGainStage--;
-
-						// change gain
-						pga112_setGain(pgm_read_byte(&mc_uintPGAGains[m_uintGainStage]));
-
-						// set next state & fcn return value
-						m_gasCurrentState = GA_GATHERANLYZE1;
-						blnReturnValue = TRUE;
-					}
-					else
-					{
-						// reset sample counter
-						m_uintSampleCounter = 0;
-
-						// set next state
-						m_gasCurrentState = GA_WAIT;
-					}
+					// the run ends with this sample (the following ones are discarded after the gain change)
+					blnClipAttack = TRUE;
+					uintRun -= (uint8_t) (puintEnd - puintSamples);
+					puintEnd = puintSamples;
 				}
-				else
-					m_gasCurrentState = GA_GATHERANLYZE1;
+			}
+			else
+				uintClipRun = 0;
 
-#ifdef DEBUGGING
-				alarms_set_gain(m_uintGainStage);
-#endif
+#ifdef GAINADJUST_QUALITY
+			// quality record (of the unfiltered samples)
+			uintQualitySum += uintSample;
+			if(uintSample > uintQualityMax)
+				uintQualityMax = uintSample;
+			else if(uintSample < uintQualityMin)
+				uintQualityMin = uintSample;
+			if(uintSample >= uintQualityMean)
+			{
+				uintQualityDeviation += uintSample - uintQualityMean;
+				if(!blnQualityAbove)
+				{
+					uintQualityCrossings++;
+					blnQualityAbove = TRUE;
+				}
+			}
+			else
+			{
+				uintQualityDeviation += uintQualityMean - uintSample;
+				if(blnQualityAbove)
+				{
+					uintQualityCrossings++;
+					blnQualityAbove = FALSE;
+				}
 			}
-		break;
+#endif
 
-		case GA_WAIT:
-			if(++m_uintSampleCounter == GAINADJUST_DATAWINDOW)
+#ifdef GAINADJUST_DC_BLOCKER
+			// remove the baseline and centre the sample at mid-scale
+			uintShifted = (uint16_t) uintSample << GA_DC_FRAC;
+			uintDCBaseline = dsp_iir1U16(uintDCBaseline, uintShifted, GAINADJUST_DC_SHIFT);
+			if(uintShifted > uintDCBaseline)
+			{
+				uintShifted = (uintShifted - uintDCBaseline) >> GA_DC_FRAC;
+				uintSample = (uintShifted < GA_DC_MID) ? (EEG_SAMPLE) (GA_DC_MID + uintShifted) : GA_FULLSCALE;
+			}
+			else
 			{
-				m_blnWaitStateComplete = TRUE;
+				uintShifted = (uintDCBaseline - uintShifted) >> GA_DC_FRAC;
+				uintSample = (uintShifted < GA_DC_MID) ? (EEG_SAMPLE) (GA_DC_MID - uintShifted) : 0;
+			}
+#endif
 
-				// initialize local min & max variables
-				m_uintLocalMax = m_uintLocalMin = uintNewSample;
-				
-				// reset sample counter
-				m_uintSampleCounter = 1;
+#if defined(GAINADJUST_HISTOGRAM)
+			m_uintHistogram[uintSample >> GA_HIST_SHIFT]++;
+#elif defined(GAINADJUST_ENVELOPE)
+			uintRect = (uint16_t) uintSample << GA_ENV_FRAC;
+			uintBaseline = dsp_iir1U16(uintBaseline, uintRect, GAINADJUST_ENV_DC_SHIFT);
+			uintRect = (uintRect > uintBaseline) ? (uint16_t) (uintRect - uintBaseline) : (uint16_t) (uintBaseline - uintRect);
+			if(uintRect > uintPeak)
+				uintPeak = uintRect;
+#else
+			if(uintSample > uintMax)
+				uintMax = uintSample;
+			else if(uintSample < uintMin)
+				uintMin = uintSample;
+#endif
+		}
 
-				// set next state
-				m_gasCurrentState = GA_GATHERANLYZE2;
+		m_uintClipRun = uintClipRun;
+#ifdef GAINADJUST_DC_BLOCKER
+		m_uintDCBaseline = uintDCBaseline;
+#endif
+#ifdef GAINADJUST_QUALITY
+		m_uintQualitySamples += uintRun;
+		m_uintQualitySum = uintQualitySum;
+		m_uintQualityDeviation = uintQualityDeviation;
+		m_uintQualityMax = uintQualityMax;
+		m_uintQualityMin = uintQualityMin;
+		m_uintQualityClipped = uintQualityClipped;
+		m_uintQualityCrossings = uintQualityCrossings;
+		m_blnQualityAbove = blnQualityAbove;
+#endif
+#ifdef GAINADJUST_MAINS
+		mn_process(puintEnd - uintRun, uintRun);
+#endif
+#if defined(GAINADJUST_ENVELOPE)
+		m_uintBaseline = uintBaseline;
+		m_uintPeak = uintPeak;
+#elif defined(GA_MINMAX)
+		m_uintLocalMax = uintMax;
+		m_uintLocalMin = uintMin;
+#endif
+
+		// fast attack (after the state of the run was stored, since the gain change rescales or resets it)
+		if(blnClipAttack)
+		{
+			ga_setStage(ga_targetStage(GA_FULLSCALE, GA_FULLSCALE, FALSE));
+#ifdef GAINADJUST_STATISTICS
+			if(m_Statistics.uintClipDecreases < 0xFFFF)
+				m_Statistics.uintClipDecreases++;
+#endif
+			*puintIndex = (uint8_t) (puintSamples - puintStart - 1);
+			GA_TIMING_END();
+			return TRUE;
+		}
+
+		// block complete
+		if(m_uintSampleCounter == GA_BLOCK_LENGTH)
+		{
+			m_uintSampleCounter = 0;
+#ifdef GAINADJUST_QUALITY
+			if(++m_uintQualityBlocks == GA_WINDOW_BLOCKS)
+				ga_closeQuality(0);
+#endif
+			if(ga_closeBlock())
+			{
+				*puintIndex = (uint8_t) (puintSamples - puintStart - 1);
+				GA_TIMING_END();
+				return TRUE;
 			}
-		break;
+			uintClipRun = m_uintClipRun;
+		}
 	}
 
-	return blnReturnValue;
+	GA_TIMING_END();
+	return FALSE;
+}
+
+/**
+ * \brief		Sets the gain level directly (e.g. while the gain adjustment is suspended).
+ *
+ * \param[in]	uintStage		new gain level (limited to \a GAINADJUST_NSTAGES - 1)
+ *
+ * \return		TRUE if the gain level was changed, FALSE otherwise
+ */
+BOOL ga_setGainStage(uint8_t uintStage)
+{
+	if(uintStage >= GAINADJUST_NSTAGES)
+		uintStage = GAINADJUST_NSTAGES - 1;
+
+	return ga_setStage(uintStage);
 }
 
+/**
+ * \brief		Returns the current gain stage.
+ *
+ * \return		gain stage (0 = lowest gain, \a GAINADJUST_NSTAGES - 1 = highest gain)
+ */
+uint8_t ga_getGainStage(void)
+{
+	return m_uintGainStage;
+}
+
+/**
+ * \brief		Sets the PGA gain that produces the display scale signal of the current gain level.
+ *
+ * \details		The display scale signal of gain level \e n has an amplitude of GAINADJUST_DISPSCALE_UV * 2^\e n
+ *				(i.e. 0.625 mV, 1.25 mV, 2.5 mV, ...).
+ */
 void ga_enterDisplayScale(void)
 {
-	switch(m_uintGainStage)
-	{
-		// Gain step 1: 0.625 mV output signal required => set PGA gain = 1
-		case 0:
-			pga112_setGain(PGA112_G1);
-		break;
-
-		// Gain step 2: 1.250 mV output signal required => set PGA gain = 2
-		case 1:
-			pga112_setGain(PGA112_G2);
-		break;
-
-		// Gain step 3: 2.500 mV output signal required => set PGA gain = 4
-		case 2:
-			pga112_setGain(PGA112_G4);
-		break;
-
-		// Gain step 4: 5.00 mV output signal required => set PGA gain = 8
-		case 3:
-			pga112_setGain(PGA112_G8);
-		break;
-
-		default:
-			alarms_set(AL_FATALERROR);
-		break;
-	}
+	if(m_uintGainStage < GAINADJUST_NSTAGES)
+		pga112_setGain(pgm_read_byte(&mc_uintDisplayScaleGains[m_uintGainStage]));
+	else
+		alarms_set(AL_FATALERROR);
 }
 
 void ga_exitDisplayScale(void)
@@ -227,3 +995,34 @@ void ga_exitDisplayScale(void)
 	// set PGA gain to pre-Display Scale state value
 	pga112_setGain(pgm_read_byte(&mc_uintPGAGains[m_uintGainStage]));
 }
+
+#ifdef GAINADJUST_QUALITY
+/**
+ * \brief		Retrieves the oldest signal quality record.
+ *
+ * \details		A record is produced for every \a GA_WINDOW_BLOCKS blocks of processed samples, or earlier if the
+ *				gain is changed. Records are lost if they aren't read in time.
+ *
+ * \param[out]	pQuality		structure in which the record is stored
+ *
+ * \return		TRUE if a record was retrieved, FALSE if there are no records
+ */
+BOOL ga_getQuality(struct GA_QUALITY * pQuality)
+{
+	return rb_quality_get(pQuality);
+}
+#endif
+
+#ifdef GAINADJUST_STATISTICS
+/**
+ * \brief		Returns the statistics of the gain controller.
+ *
+ * \details		The cycles spent per sample can be measured on pin PC1 (see ga_processBlock()).
+ *
+ * \param[out]	pStatistics		structure in which the statistics are stored
+ */
+void ga_getStatistics(struct GA_STATISTICS * pStatistics)
+{
+	*pStatistics = m_Statistics;
+}
+#endif
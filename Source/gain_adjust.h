@@ -16,28 +16,100 @@
 //----------------------------------------------------------------------------------------------------------
 //   								Definitions
 //----------------------------------------------------------------------------------------------------------
-//#define GAINADJUST_DATAWINDOW		2604							///< number of EEG samples that must be analyzed prior to gain adjustment \n NOTE 1: must be a power of 2 \n NOTE 2: if value greater or equal than 2^16, must change data type of associated variables to \c int32
-#define GAINADJUST_DATAWINDOW		2500							///< number of EEG samples that must be analyzed prior to gain adjustment \n NOTE 1: must be a power of 2 \n NOTE 2: if value greater or equal than 2^16, must change data type of associated variables to \c int32
-#define GAINADJUST_NSTAGES			4								///< number of gain levels
+#define GAINADJUST_DATAWINDOW		2500							///< length of the sliding window over which the P-P amplitude is measured (in EEG samples; rounded up to a whole number of blocks, max. 255 blocks)
+//#define GAINADJUST_HISTOGRAM										///< if defined, the P-P amplitude is measured between two percentiles of a histogram of the window's samples instead of between its min & max (see \a GAINADJUST_HIST_PERCENT)
+#define GAINADJUST_HIST_BITS		5								///< base-2 logarithm of the number of histogram bins (1 - 8; 2 bytes of SRAM per bin)
+#define GAINADJUST_HIST_PERCENT		2								///< percentage of the window's samples that is ignored at each end of the histogram (0 - 25; 2 => amplitude between 2nd & 98th percentile)
+
+//#define GAINADJUST_ENVELOPE										///< if defined, the P-P amplitude is taken from an envelope follower with separate attack & release time constants instead of the window's min & max (excludes \a GAINADJUST_HISTOGRAM)
+#define GAINADJUST_ENV_DC_SHIFT		9								///< time constant of the baseline removed before rectification (2^n samples; 9 => 0.2 s at 2500 Hz)
+#define GAINADJUST_ENV_ATTACK_SHIFT	1								///< attack time constant of the envelope (2^n blocks; 1 => 26 ms)
+#define GAINADJUST_ENV_RELEASE_SHIFT	6							///< release time constant of the envelope (2^n blocks; 6 => 0.8 s)
+#define GAINADJUST_ENV_MARGIN_SHIFT	3							///< before the gain is increased, the amplitude is raised by 2^-n to allow for the sag of the envelope between peaks (3 => 12.5 %)
+
+//#define GAINADJUST_DC_BLOCKER										///< if defined, the baseline is removed from the samples with a first-order high-pass filter before the min/max or histogram amplitude estimation, so that electrode drift doesn't inflate the P-P amplitude (\a GAINADJUST_ENVELOPE removes the baseline itself)
+#define GAINADJUST_DC_SHIFT			10								///< time constant of the DC blocker (4 - 12; 2^n samples, corner frequency = 2500 Hz / (2 * pi * 2^n): 9 => 0.78 Hz, 10 => 0.39 Hz)
+
+#define GAINADJUST_NSTAGES			8								///< number of gain levels (1 - 8; must be a plain decimal number, since it is used to generate the gain tables); each level doubles the PGA gain of the previous one
+#define GAINADJUST_MIN_LOG2GAIN		0								///< base-2 logarithm of the PGA gain of the lowest gain level (0 = PGA gain 1, ..., 7 = PGA gain 128)
+#define GAINADJUST_INITIAL_STAGE	3								///< gain level selected by ga_init(), i.e. at power-up (0 - GAINADJUST_NSTAGES - 1; 3 => PGA gain 8, the highest level of the former four-level ladder)
+
+#define GAINADJUST_VREF_MV			3300							///< ADC reference voltage (AVCC, in mV)
+#define GAINADJUST_UPPER_MV			1150							///< P-P amplitude at the ADC input at or above which the gain is decreased (in mV)
+#define GAINADJUST_LOWER_MV			570								///< P-P amplitude at the ADC input at or below which the gain is increased (in mV)
+
+#define GAINADJUST_SETTLE_SAMPLES	8								///< number of samples ignored after a reset (e.g. at the start of the Recording state), while the front end settles after a gain or switch change (1 - 255)
+
+#define GAINADJUST_CLIP_MARGIN		2								///< distance from the ADC rails (0 & full scale) within which a sample counts as clipped (in 8-bit ADC counts)
+#define GAINADJUST_CLIP_RUN			8								///< number of consecutive clipped samples that force an immediate gain decrease (1 - 255; 8 samples = 3.2 ms at 2500 Hz)
+
+#define GAINADJUST_DISPSCALE_UV		625								///< amplitude of the display scale signal that indicates the lowest gain level (in uV; doubles with each gain level)
+#define GAINADJUST_DISPPULSE_UV		625								///< amplitude of the display scale pulse at the adapter's output with PGA gain 1 (in uV)
+
+//#define GAINADJUST_MAINS											///< if defined, the P-P amplitude of the 50/60 Hz mains interference (see mains.c) is removed from the measured P-P amplitude, so that mains pickup doesn't drive the gain down
+
+//#define GAINADJUST_QUALITY										///< if defined, a signal quality record (see \c GA_QUALITY) is produced for every window of \a GAINADJUST_DATAWINDOW samples
+#define GAINADJUST_QUALITY_RECORDS	4								///< number of quality records that can be stored until they are read (must be a power of 2; one slot is always kept empty)
+#define GAINADJUST_QUALITY_CREST_SHIFT	4							///< a window is flagged as artifact if its P-P amplitude exceeds 2^n times its mean absolute deviation (sine: approx. 3, Gaussian noise: approx. 9)
+
+//#define GAINADJUST_STATISTICS										///< if defined, the behaviour of the gain controller is recorded in a \c GA_STATISTICS structure (see ga_getStatistics())
+//#define GAINADJUST_TIMING											///< if defined, PC1 is high while ga_processBlock() runs instead of being toggled at each call, so the cycles per call can be measured with an oscilloscope (see ga_processBlock())
 
 //----------------------------------------------------------------------------------------------------------
-//   								Enums
+//   								Enums/Structs
 //----------------------------------------------------------------------------------------------------------
+#ifdef GAINADJUST_QUALITY
 /**
- * Enumeration whose members are used as return values of ga_newsample()
+ * Flags of a quality record.
  */
-enum GA_STATE {GA_GATHERANLYZE1 = 0,	///< gain level has not changed
-			   GA_GATHERANLYZE2,		///<
-			   GA_WAIT					///<
-			  };
+enum GA_QUALITY_FLAGS {GA_Q_CLIPPED = 0x01,		///< at least one sample of the window was clipped
+					   GA_Q_ARTIFACT = 0x02,	///< the P-P amplitude is large compared to the mean absolute deviation (see \a GAINADJUST_QUALITY_CREST_SHIFT)
+					   GA_Q_GAINCHANGE = 0x04	///< the window was cut short by a gain change
+					  };
+
+/**
+ * Signal quality record of one window (all amplitudes in ADC counts at the resolution of the EEG samples).
+ */
+struct GA_QUALITY {EEG_SAMPLE	uintPeakToPeak;		///< P-P amplitude
+				   EEG_SAMPLE	uintMean;			///< mean (DC level)
+				   EEG_SAMPLE	uintDeviation;		///< mean absolute deviation from the mean of the previous window (variance proxy)
+				   uint16_t		uintClipped;		///< number of clipped samples
+				   uint16_t		uintCrossings;		///< number of crossings of the mean of the previous window (zero-crossing rate)
+				   uint8_t		uintGainStage;		///< gain level during the window
+				   uint8_t		uintFlags;			///< combination of \c GA_QUALITY_FLAGS
+				  };
+#endif
+
+#ifdef GAINADJUST_STATISTICS
+/**
+ * Statistics of the gain controller since ga_init().
+ */
+struct GA_STATISTICS {uint32_t	uintSamples;			///< number of samples that were passed to ga_processBlock() & ga_newsample()
+					  uint32_t	uintLastChange;			///< value of \a uintSamples at the most recent gain change (i.e. convergence time)
+					  uint32_t	uintClippedSamples;		///< number of samples within \a GAINADJUST_CLIP_MARGIN of the ADC rails
+					  uint16_t	uintIncreases;			///< number of gain increases (saturates at 65535)
+					  uint16_t	uintDecreases;			///< number of gain decreases, including the ones forced by clipping (saturates at 65535)
+					  uint16_t	uintClipDecreases;		///< number of gain decreases forced by clipping (saturates at 65535)
+					  uint16_t	uintReversals;			///< number of gain changes in the opposite direction of the previous one, i.e. oscillations (saturates at 65535)
+					 };
+#endif
 
 //----------------------------------------------------------------------------------------------------------
 //   								Prototypes
 //----------------------------------------------------------------------------------------------------------
 void			ga_init(void);
 void			ga_reset(void);
-BOOL			ga_newsample(const uint8_t uintNewSample);
+BOOL			ga_newsample(const EEG_SAMPLE uintNewSample);
+BOOL			ga_processBlock(const EEG_SAMPLE * puintSamples, uint8_t uintCount, uint8_t * puintIndex);
+BOOL			ga_setGainStage(uint8_t uintStage);
+uint8_t			ga_getGainStage(void);
 void			ga_enterDisplayScale(void);
 void			ga_exitDisplayScale(void);
+#ifdef GAINADJUST_QUALITY
+BOOL			ga_getQuality(struct GA_QUALITY * pQuality);
+#endif
+#ifdef GAINADJUST_STATISTICS
+void			ga_getStatistics(struct GA_STATISTICS * pStatistics);
+#endif
 
 #endif
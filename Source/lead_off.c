@@ -0,0 +1,179 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		lead_off.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ * \version		1.0.0
+ *
+ * \brief		Module that detects detached electrodes from the EEG signal.
+ *
+ * \details		The EEG samples are checked in windows of \a LO_WINDOW_MSEC. A window is implausible if the signal
+ *				can't be brought into range by the gain adjustment:\n
+ *				- its P-P amplitude (less \a LO_NOISE_COUNTS), scaled to the highest gain level, is at most
+ *				  \a LO_FLAT_COUNTS (flat line)\n
+ *				- at least \a LO_RAIL_PERCENT of its samples are clipped at the lowest gain level (rail-pinned)\n
+ *				- its P-P amplitude, scaled to the lowest gain level, is at least \a LO_LARGE_PERCENT of the ADC range
+ *
+ *				The electrodes are reported as detached after the first implausible window and as attached again after
+ *				\a LO_CLEAR_WINDOWS plausible windows. While they are detached, the gain should be kept at the level
+ *				at which a reattachment is recognized soonest: the highest level for a flat line (a reattached
+ *				electrode can't be flat there), the lowest one otherwise (a reattached electrode can't be railed or too
+ *				large there; if the EEG is too small to be seen, the state turns into a flat line).
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// AVR-LibC headers
+#include <avr/io.h>
+
+// application headers
+#include "globals.h"
+#include "drivers/avr_adc.h"
+#include "drivers/avr_timer1.h"
+#include "gain_adjust.h"
+#include "lead_off.h"
+
+//----------------------------------------------------------------------------------------------------------
+//   								Constants
+//----------------------------------------------------------------------------------------------------------
+#define LO_WINDOW_SAMPLES		((uint16_t) (((uint32_t) LO_WINDOW_MSEC * TMR1_SAMPLING_RATE_HZ) / 1000))		///< length of the windows (in EEG samples)
+#define LO_FULLSCALE			((EEG_SAMPLE) ((1UL << ADC_EEG_RESOLUTION) - 1))							///< largest EEG sample value
+#define LO_CLIP_LOW				((EEG_SAMPLE) (GAINADJUST_CLIP_MARGIN << (ADC_EEG_RESOLUTION - 8)))			///< samples at or below this value are considered clipped
+#define LO_CLIP_HIGH			((EEG_SAMPLE) (LO_FULLSCALE - LO_CLIP_LOW))									///< samples at or above this value are considered clipped
+#define LO_NOISE				((EEG_SAMPLE) (LO_NOISE_COUNTS << (ADC_EEG_RESOLUTION - 8)))				///< \a LO_NOISE_COUNTS at the resolution of the EEG samples
+#define LO_FLAT_LIMIT			((uint32_t) LO_FLAT_COUNTS << (ADC_EEG_RESOLUTION - 8))						///< \a LO_FLAT_COUNTS at the resolution of the EEG samples
+#define LO_RAIL_SAMPLES			((uint16_t) (((uint32_t) LO_WINDOW_SAMPLES * LO_RAIL_PERCENT) / 100))		///< \a LO_RAIL_PERCENT in EEG samples
+#define LO_LARGE_LIMIT			((EEG_SAMPLE) (((uint32_t) LO_FULLSCALE * LO_LARGE_PERCENT) / 100))			///< \a LO_LARGE_PERCENT in ADC counts
+
+#if ((LO_WINDOW_MSEC * TMR1_SAMPLING_RATE_HZ) / 1000 < ADC_EEG_BLOCK_LENGTH) || (LO_WINDOW_MSEC > 10000)
+#error "LO_WINDOW_MSEC must be between one block of EEG samples and 10 sec"
+#endif
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+static enum LO_STATE	m_State;								///< current electrode contact state
+static uint8_t			m_uintGoodWindows;						///< number of consecutive plausible windows while the electrodes are detached
+
+static uint16_t			m_uintSamples;							///< number of samples in the current window
+static uint16_t			m_uintRailSamples;						///< number of clipped samples in the current window
+static EEG_SAMPLE		m_uintMax;								///< largest sample of the current window
+static EEG_SAMPLE		m_uintMin;								///< smallest sample of the current window
+
+//----------------------------------------------------------------------------------------------------------
+//   								Static Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Classifies the current window.
+ *
+ * \return		\c LO_CONTACT if the window is plausible, otherwise the reason why it isn't
+ */
+static enum LO_STATE lo_checkWindow(void)
+{
+	EEG_SAMPLE uintAmplitude = m_uintMax - m_uintMin;
+	uint8_t uintStage = ga_getGainStage();
+
+	// a signal that is pinned to a rail is flat as well, but must not park the gain at the highest level (above the
+	// lowest level, the gain adjustment decreases the gain first)
+	if(m_uintRailSamples >= LO_RAIL_SAMPLES)
+		return (uintStage == 0) ? LO_RAIL : LO_CONTACT;
+
+	if(uintAmplitude <= LO_NOISE)
+		return LO_FLAT;
+	if(((uint32_t) (uintAmplitude - LO_NOISE) << (GAINADJUST_NSTAGES - 1 - uintStage)) <= LO_FLAT_LIMIT)
+		return LO_FLAT;
+
+	if((uintStage == 0) && (uintAmplitude >= LO_LARGE_LIMIT))
+		return LO_LARGE;
+
+	return LO_CONTACT;
+}
+
+//----------------------------------------------------------------------------------------------------------
+//   								Code
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Initializes the module (the electrodes are assumed to be attached).
+ *
+ * \note		This function must be called before any other function in this module.
+ */
+void lo_init(void)
+{
+	m_State = LO_CONTACT;
+	m_uintGoodWindows = 0;
+	lo_reset();
+}
+
+/**
+ * \brief		Discards the current window (e.g. after a gain change).
+ */
+void lo_reset(void)
+{
+	m_uintSamples = 0;
+	m_uintRailSamples = 0;
+}
+
+/**
+ * \brief		Checks new EEG samples.
+ *
+ * \param[in]	puintSamples	new EEG samples
+ * \param[in]	uintCount		number of samples
+ *
+ * \return		TRUE if the contact state (or the reason why the electrodes are considered detached) changed,
+ *				FALSE otherwise
+ */
+BOOL lo_processBlock(const EEG_SAMPLE * puintSamples, uint8_t uintCount)
+{
+	EEG_SAMPLE uintSample;
+	enum LO_STATE state;
+	BOOL blnChanged = FALSE;
+
+	while(uintCount--)
+	{
+		uintSample = *puintSamples++;
+
+		if(m_uintSamples == 0)
+			m_uintMax = m_uintMin = uintSample;
+		else if(uintSample > m_uintMax)
+			m_uintMax = uintSample;
+		else if(uintSample < m_uintMin)
+			m_uintMin = uintSample;
+
+		if((uintSample <= LO_CLIP_LOW) || (uintSample >= LO_CLIP_HIGH))
+			m_uintRailSamples++;
+
+		if(++m_uintSamples == LO_WINDOW_SAMPLES)
+		{
+			state = lo_checkWindow();
+			if(state != LO_CONTACT)
+			{
+				m_uintGoodWindows = 0;
+				if(m_State != state)
+					blnChanged = TRUE;
+				m_State = state;
+			}
+			else if((m_State != LO_CONTACT) && (++m_uintGoodWindows == LO_CLEAR_WINDOWS))
+			{
+				m_uintGoodWindows = 0;
+				m_State = LO_CONTACT;
+				blnChanged = TRUE;
+			}
+
+			lo_reset();
+		}
+	}
+
+	return blnChanged;
+}
+
+/**
+ * \brief		Returns the electrode contact state.
+ *
+ * \return		\c LO_CONTACT if the electrodes are attached, otherwise the reason why they are considered detached
+ */
+enum LO_STATE lo_getState(void)
+{
+	return m_State;
+}
@@ -0,0 +1,44 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		lead_off.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Header file of module that detects detached electrodes from the EEG signal.
+ */
+
+#ifndef __LEAD_OFF_H__
+#define __LEAD_OFF_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Application-Specific Definitions
+//----------------------------------------------------------------------------------------------------------
+#define LO_WINDOW_MSEC				250		///< length of the windows over which the signal is checked (in msec)
+#define LO_NOISE_COUNTS				1		///< ADC noise (in 8-bit ADC counts) that is subtracted from the P-P amplitude before the flat-line check
+#define LO_FLAT_COUNTS				2		///< P-P amplitude (in 8-bit ADC counts) at or below which the signal is flat, if it were amplified with the highest gain level
+#define LO_RAIL_PERCENT				90		///< percentage of clipped samples (see \a GAINADJUST_CLIP_MARGIN) at or above which the signal is pinned to a rail at the lowest gain level
+#define LO_LARGE_PERCENT			95		///< P-P amplitude (in percent of the ADC range) at or above which the signal is implausibly large, if it were amplified with the lowest gain level
+#define LO_CLEAR_WINDOWS			2		///< number of consecutive plausible windows after which the electrodes are considered to be attached again
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Electrode contact states.
+ */
+enum LO_STATE {LO_CONTACT = 0,		///< the signal is plausible
+			   LO_FLAT,				///< the signal is flat even at the highest gain level
+			   LO_RAIL,				///< the signal is pinned to an ADC rail at the lowest gain level
+			   LO_LARGE				///< the signal is too large even at the lowest gain level
+			  };
+
+//----------------------------------------------------------------------------------------------------------
+//   								Prototypes
+//----------------------------------------------------------------------------------------------------------
+void			lo_init(void);
+void			lo_reset(void);
+BOOL			lo_processBlock(const EEG_SAMPLE * puintSamples, uint8_t uintCount);
+enum LO_STATE	lo_getState(void);
+
+#endif
@@ -21,14 +21,20 @@
 #include <avr/sleep.h>
 #include <avr/wdt.h>
 
+// standard C headers (also from AVR-LibC)
+#include <stddef.h>
+
 // application headers
 #include "globals.h"
 #include "main.h"
+#include "drivers/avr_adc.h"
 #include "acc_check.h"
 #include "alarms.h"
+#include "display_scale.h"
+#include "events.h"
 #include "gain_adjust.h"
+#include "lead_off.h"
 #include "calibration/calib_RC_32kHz.h"
-#include "drivers/avr_adc.h"
 #include "drivers/avr_timer0.h"
 #include "drivers/avr_timer1.h"
 #include "drivers/avr_timer2.h"
@@ -45,11 +51,6 @@ static void (*m_StateMachine[])(void) = {&state_init, &state_standby, &state_rec
 //----------------------------------------------------------------------------------------------------------
 static enum BACKGROUND_STATES		m_bkgState;			///< current state of the background loop state machine
 
-// Variables from the ADC driver
-extern volatile uint8_t				m_uintEEGSamples[256];
-extern volatile uint8_t				m_uintNUnreadSamplesEEG;
-extern volatile uint8_t				m_uintEEGSamplesWPtr, m_uintEEGSamplesRPtr;
-
 // variables from the Timer/Counter1 driver
 extern volatile BOOL				m_blnTC1_ADC;
 extern volatile BOOL				m_blnTC1_StateTransition;
@@ -77,6 +78,9 @@ int main(void)
 	{
 		wdt_reset();
 		m_StateMachine[m_bkgState]();
+
+		// timestamp the transition to the next state
+		ev_stamp(EV_STATE, (uint8_t) m_bkgState);
 	}
 
 	return 0;
@@ -151,6 +155,12 @@ static void state_init(void)
 	// Gain adjustment module
 	ga_init();
 
+	// Event timestamps
+	ev_init();
+
+	// Display Scale scheduling
+	ds_init();
+
 	// enable watchdog
 	wdt_enable(WDTO_2S);
 
@@ -214,6 +224,8 @@ static void state_standby(void)
 						//
 						// touch was detected
 						//
+						ev_stamp(EV_TOUCH, (uint8_t) BST_STANDBY);
+
 						// stop TC2, initialize TC0 and flash BLUE LED
 						alarms_set(AL_KEY_PRESS);
 						
@@ -314,6 +326,7 @@ static void state_standby(void)
 						// no touch detected => go to recording state
 						//
 						alarms_clear(AL_KEY_HOLD);
+						ds_init();
 						m_bkgState = BST_RECORDING;
 					}
 				}
@@ -367,7 +380,17 @@ static void state_recording(void)
 	dbg_indicate_state(BST_RECORDING);
 #endif
 
-	uint8_t uintNewSample;
+	const EEG_SAMPLE * puintBlock;
+	uint8_t i;
+	uint8_t uintOffset;
+	BOOL blnGainChanged;
+	uint32_t uintBlockIndex;
+	uint32_t uintResumeIndex;
+	struct ADC_STATISTICS statistics;
+	uint16_t uintOverruns;
+#ifdef ADC_SEQUENCER
+	uint8_t uintAccSample;
+#endif
 
 	// peripheral init:
 	// - software modules: alarms, gain_adjust
@@ -378,14 +401,24 @@ static void state_recording(void)
 	alarms_set(AL_RECORDING);
 	qtouch_init();
 	avr_adc_init();
+	ac_init();
 	avr_tc1_init(TMR1_RECORDING, RECORDING_STATE_DURATION_SEC);
 	avr_tc2_init(TMR2_RECORDING);
 	ga_reset();
+	lo_init();
 	qtouch_statemachine_init(RECORDING_TOUCH_LENGTH_MIN_MSEC, RECORDING_TOUCH_LENGTH_MAX_MSEC);
 	sei();
 
+	// overruns that were already counted in earlier Recording state episodes
+	avr_adc_getStatistics(&statistics);
+	uintOverruns = statistics.uintOverruns;
+
+	// index of the first sample that is acquired with the current gain
+	uintResumeIndex = avr_adc_getSampleIndex();
+
 	while(m_bkgState == BST_RECORDING)
 	{
+#ifndef ADC_AUTO_TRIGGER
 		//
 		// start ADC conversion
 		//
@@ -400,25 +433,99 @@ static void state_recording(void)
 			// kick the dog
 			wdt_reset();
 		}
+#endif
 		
 		//
-		// deal with the ADC results
+		// deal with the ADC results (one block at a time)
 		//
-		while(m_uintNUnreadSamplesEEG > 0)
+		while((puintBlock = avr_adc_getBlock()) != NULL)
 		{
-			// get next new data sample & increase read pointer
-			uintNewSample = m_uintEEGSamples[m_uintEEGSamplesRPtr++];
-					
-			// send new sample to module that adjusts the adapter's gain
-			if(ga_newsample(uintNewSample))
-				m_bkgState = BST_DISPLAYSCALE;
+			// skip the samples that were acquired with the previous gain
+			uintBlockIndex = avr_adc_getBlockIndex();
+			uintOffset = 0;
+			if((int32_t) (uintResumeIndex - uintBlockIndex) > 0)
+				uintOffset = (uintResumeIndex - uintBlockIndex < ADC_EEG_BLOCK_LENGTH) ? (uint8_t) (uintResumeIndex - uintBlockIndex) : ADC_EEG_BLOCK_LENGTH;
+
+			// check the electrode contact (while the electrodes are detached the gain adjustment is suspended
+			// and the gain is parked at the level at which a reattachment is recognized soonest)
+			blnGainChanged = FALSE;
+			if(lo_processBlock(puintBlock + uintOffset, ADC_EEG_BLOCK_LENGTH - uintOffset))
+			{
+				ev_stamp(EV_LEADOFF, (uint8_t) lo_getState());
+				if(lo_getState() == LO_CONTACT)
+				{
+					// restart the gain adjustment with a new window
+					alarms_clear(AL_LEADOFF);
+					ga_reset();
+				}
+				else
+				{
+					alarms_set(AL_LEADOFF);
+					i = (uint8_t) (ADC_EEG_BLOCK_LENGTH - 1 - uintOffset);
+					blnGainChanged = ga_setGainStage((lo_getState() == LO_FLAT) ? (GAINADJUST_NSTAGES - 1) : 0);
+				}
+			}
+			// send new samples to module that adjusts the adapter's gain
+			else if((uintOffset < ADC_EEG_BLOCK_LENGTH) && (lo_getState() == LO_CONTACT))
+				blnGainChanged = ga_processBlock(puintBlock + uintOffset, ADC_EEG_BLOCK_LENGTH - uintOffset, &i);
+
+			// the Display Scale episode is scheduled by the display_scale module, so that several gain changes
+			// share one episode
+			if(blnGainChanged)
+			{
+				ev_stampAt(EV_GAIN, ga_getGainStage(), uintBlockIndex + uintOffset + i);
+				ds_gainChanged(uintBlockIndex + uintOffset + i);
+				lo_reset();
+
+				// all samples that were acquired so far used the previous gain
+				uintResumeIndex = avr_adc_getSampleIndex();
+			}
 
-			// increase sample counters & decrease unread sample counter
-			m_uintNUnreadSamplesEEG--;
+			// hand block back to the ADC driver
+			avr_adc_releaseBlock();
 
 			// kick the dog
 			wdt_reset();
 		}
+
+		//
+		// start a Display Scale episode for the pending gain changes (deferred while the electrodes are
+		// detached, since the gain is likely to change again once they are reattached)
+		//
+		if((lo_getState() == LO_CONTACT) && ds_isDue())
+			m_bkgState = BST_DISPLAYSCALE;
+
+		//
+		// timestamp buffer overruns
+		//
+		avr_adc_getStatistics(&statistics);
+		if(statistics.uintOverruns != uintOverruns)
+		{
+			ev_stamp(EV_OVERRUN, (statistics.uintOverruns - uintOverruns > 0xFF) ? 0xFF : (uint8_t) (statistics.uintOverruns - uintOverruns));
+			uintOverruns = statistics.uintOverruns;
+		}
+
+#ifdef ADC_SEQUENCER
+		//
+		// deal with the accelerometer results
+		//
+		while(avr_adc_getAccSample(ADC_ACC_X, &uintAccSample))
+			ac_new_sample(uintAccSample, AC_X);
+		while(avr_adc_getAccSample(ADC_ACC_Y, &uintAccSample))
+			ac_new_sample(uintAccSample, AC_Y);
+		while(avr_adc_getAccSample(ADC_ACC_Z, &uintAccSample))
+			ac_new_sample(uintAccSample, AC_Z);
+#endif
+		
+		//
+		// correct the sample clock against the TOSC crystal and keep the RC oscillator on F_CPU (one OSCCAL
+		// step at a time; the measurement is restarted after a step since it would mix two clock frequencies)
+		//
+		if(avr_tc1_discipline())
+		{
+			if(calibRC_Track(avr_tc1_getClockError()))
+				avr_tc1_restartMeasurement();
+		}
 		
 		//
 		// check Timer/Counter2
@@ -440,15 +547,37 @@ static void state_recording(void)
 			// check sensor
 			if(qtouch_statemachine_measurement(qtouch_measure(m_uintCurrentTimeTouch_msec)))
 			{
+				ev_stamp(EV_TOUCH, (uint8_t) BST_RECORDING);
 				m_bkgState = BST_STANDBY;
 				break;
 			}
 		}
 
+#ifdef ADC_AUTO_TRIGGER
+		//
+		// sleep until the next interrupt if there is nothing left to do
+		// (interrupts are disabled during the check so that no wake-up event is missed)
+		//
+		cli();
+		if(!avr_adc_isBlockReady() && !m_blnTC1_StateTransition && !m_uintTC2_Time2MeasureTouch)
+		{
+			// Idle sleep mode keeps clkIO running, which Timer/Counter1 needs in order to trigger the ADC
+			SLEEP(SLEEP_MODE_IDLE);
+		}
+		else
+			sei();
+#endif
+
 		// kick the dog
 		wdt_reset();
 	}
 
+#ifdef ADC_AUTO_TRIGGER
+	// stop auto-triggered conversions
+	avr_adc_disable();
+#endif
+
+	alarms_clear(AL_LEADOFF);
 	alarms_clear(AL_RECORDING);
 }
 
@@ -472,6 +601,9 @@ static void state_displayscale(void)
 	avr_tc2_init(TMR2_DISPSCALE);
 	wdt_reset();
 	sei();
+
+	// the episode displays the current gain stage, which covers all pending gain changes
+	ds_startEpisode(DISPLAY_SCALE_STATE_DURATION_SEC);
 	
 	// set PGA gain according to the current gain stage
 	ga_enterDisplayScale();
@@ -483,6 +615,9 @@ static void state_displayscale(void)
 		// (sleep bit cleared upon waking up)
 		SLEEP(SLEEP_MODE_IDLE);
 
+		// correct the state's duration against the TOSC crystal
+		avr_tc1_discipline();
+
 		// kick the dog
 		wdt_reset();
 	}
@@ -0,0 +1,290 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		mains.c
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ * \version		1.0.0
+ *
+ * \brief		Module that measures the mains interference in the EEG signal.
+ *
+ * \details		The P-P amplitude of the 50 Hz & 60 Hz mains interference and of its harmonics is measured with one
+ *				Goertzel filter per frequency. To save CPU time the EEG samples are first decimated by
+ *				\a MN_DECIMATION (sum of 5 samples, i.e. 500 Hz), and each filter runs over frames of
+ *				\a MN_FRAME_LENGTH decimated samples (0.1 s), so that all frequencies fall exactly on a bin
+ *				(k = f / 10 Hz) and the DC level of the signal cancels. The attenuation of the decimation filter is
+ *				compensated for in the conversion to P-P amplitude. Harmonics above 250 Hz alias into the bins attenuated by
+ *				the decimation filter (e.g. 350 Hz into 150 Hz).
+ *
+ *				Cost: one addition per sample and, per decimated sample, one 32x16-bit multiplication per bin (approx.
+ *				10 - 15 % of the 1600 CPU cycles per sample with 6 bins); at the end of each frame one square root per bin.
+ *
+ *				The module is only compiled if \a GAINADJUST_MAINS is defined, since its sole user is the gain
+ *				adjustment module.
+ */
+
+//----------------------------------------------------------------------------------------------------------
+//   								Includes
+//----------------------------------------------------------------------------------------------------------
+// AVR-LibC headers
+#include <avr/pgmspace.h>
+
+// standard C headers (also from AVR-LibC)
+#include <stdint.h>
+
+// application headers
+#include "globals.h"
+#include "drivers/avr_adc.h"
+#include "drivers/avr_timer1.h"
+#include "gain_adjust.h"
+#include "mains.h"
+
+#ifdef GAINADJUST_MAINS
+
+//----------------------------------------------------------------------------------------------------------
+//   								Constants
+//----------------------------------------------------------------------------------------------------------
+#define MN_DECIMATION			5															///< number of EEG samples summed into one decimated sample
+#define MN_FRAME_LENGTH			50															///< number of decimated samples over which the Goertzel filters run
+#define MN_NBINS				(2 * MN_HARMONICS)											///< number of measured frequency bins
+#define MN_COEF_BITS			14															///< number of fractional bits of the Goertzel coefficients
+#define MN_INPUT_SHIFT			(ADC_EEG_RESOLUTION - 8)									///< right shift that reduces the EEG samples to 8 bits (keeps the filter states within 32 bits)
+#define MN_FULLSCALE			((1UL << ADC_EEG_RESOLUTION) - 1)							///< largest EEG sample value
+
+#if (TMR1_SAMPLING_RATE_HZ != 2500)
+#error "The Goertzel coefficients of the mains detector are computed for a sampling rate of 2500 Hz"
+#endif
+
+#if (MN_HARMONICS < 1) || (MN_HARMONICS > 3)
+#error "MN_HARMONICS must be between 1 and 3"
+#endif
+
+static const int16_t mc_intCoefs[6] PROGMEM = {26510, 23887, 10126, 2058, -10126, -20887};	///< Goertzel coefficient 2 * cos(2 * pi * k / MN_FRAME_LENGTH) of each bin (Q14)
+
+static const uint16_t mc_uintScales[6] PROGMEM = {1065, 1073, 1118, 1151, 1214, 1300};		///< factor (Q16) that converts the magnitude of each bin into the P-P amplitude in 8-bit counts: 4 / (MN_FRAME_LENGTH * MN_DECIMATION * g(f)), with g(f) the gain of the decimation filter at the bin's frequency
+
+//----------------------------------------------------------------------------------------------------------
+//   								Variables
+//----------------------------------------------------------------------------------------------------------
+static int32_t			m_intS1[MN_NBINS];						///< Goertzel filter states s[n - 1]
+static int32_t			m_intS2[MN_NBINS];						///< Goertzel filter states s[n - 2]
+static uint16_t			m_uintBinAmplitude[MN_NBINS];			///< P-P amplitude of each bin in the last complete frame (in ADC counts at the resolution of the EEG samples)
+
+static uint16_t			m_uintDecSum;							///< sum of the current decimated sample
+static uint8_t			m_uintDecCount;							///< number of EEG samples in \a m_uintDecSum
+static uint16_t			m_uintFrameSum;							///< sum of the decimated samples of the current frame
+static uint8_t			m_uintFrameCount;						///< number of decimated samples in the current frame
+static int16_t			m_intOffset;							///< DC level that is subtracted from the decimated samples (mean of the previous frame)
+static BOOL				m_blnOffsetValid;						///< flag indicating that \a m_intOffset is valid
+
+//----------------------------------------------------------------------------------------------------------
+//   								Static Functions
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Computes the integer square root.
+ *
+ * \param[in]	uintValue	radicand
+ *
+ * \return		square root of \a uintValue (rounded down)
+ */
+static uint16_t mn_sqrt(uint32_t uintValue)
+{
+	uint32_t uintRoot = 0;
+	uint32_t uintBit = 1UL << 30;
+
+	while(uintBit > uintValue)
+		uintBit >>= 2;
+
+	while(uintBit)
+	{
+		if(uintValue >= uintRoot + uintBit)
+		{
+			uintValue -= uintRoot + uintBit;
+			uintRoot = (uintRoot >> 1) + uintBit;
+		}
+		else
+			uintRoot >>= 1;
+		uintBit >>= 2;
+	}
+
+	return (uint16_t) uintRoot;
+}
+
+/**
+ * \brief		Converts the Goertzel filter states into the P-P amplitude of each bin and starts a new frame.
+ *
+ * \details		The states are first reduced to 15 bits (sign included), so that the squared magnitude
+ *				s1^2 + s2^2 - coef * s1 * s2 fits into 32 bits.
+ */
+static void mn_closeFrame(void)
+{
+	int32_t intS1, intS2, intPower;
+	uint32_t uintAmplitude;
+	uint8_t i, uintShift;
+
+	for(i = 0; i < MN_NBINS; i++)
+	{
+		intS1 = m_intS1[i];
+		intS2 = m_intS2[i];
+		uintShift = 0;
+		while((intS1 >= 16384) || (intS1 < -16384) || (intS2 >= 16384) || (intS2 < -16384))
+		{
+			intS1 >>= 1;
+			intS2 >>= 1;
+			uintShift++;
+		}
+
+		intPower = intS1 * intS1 + intS2 * intS2 - ((((int16_t) pgm_read_word(&mc_intCoefs[i]) * intS1) >> MN_COEF_BITS) * intS2);
+		if(intPower < 0)
+			intPower = 0;
+
+		uintAmplitude = (((uint32_t) mn_sqrt((uint32_t) intPower) * pgm_read_word(&mc_uintScales[i])) << uintShift) >> (16 - MN_INPUT_SHIFT);
+		m_uintBinAmplitude[i] = (uint16_t) ((uintAmplitude > MN_FULLSCALE) ? MN_FULLSCALE : uintAmplitude);
+
+		m_intS1[i] = 0;
+		m_intS2[i] = 0;
+	}
+
+	m_intOffset = (int16_t) (m_uintFrameSum / MN_FRAME_LENGTH);
+	m_uintFrameSum = 0;
+	m_uintFrameCount = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------
+//   								Code
+//----------------------------------------------------------------------------------------------------------
+/**
+ * \brief		Initializes the module.
+ *
+ * \note		This function must be called before any other function in this module.
+ */
+void mn_init(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < MN_NBINS; i++)
+		m_uintBinAmplitude[i] = 0;
+	mn_reset();
+}
+
+/**
+ * \brief		Discards the current frame (e.g. after a gain change).
+ *
+ * \details		The amplitudes of the last complete frame are kept until the next frame is complete.
+ */
+void mn_reset(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < MN_NBINS; i++)
+	{
+		m_intS1[i] = 0;
+		m_intS2[i] = 0;
+	}
+	m_uintDecSum = 0;
+	m_uintDecCount = 0;
+	m_uintFrameSum = 0;
+	m_uintFrameCount = 0;
+	m_blnOffsetValid = FALSE;
+}
+
+/**
+ * \brief		Scales the measured amplitudes after a gain change.
+ *
+ * \param[in]	intLog2Ratio	base-2 logarithm of the ratio between the new & the old gain
+ */
+void mn_scale(int8_t intLog2Ratio)
+{
+	uint32_t uintAmplitude;
+	uint8_t i;
+
+	for(i = 0; i < MN_NBINS; i++)
+	{
+		if(intLog2Ratio < 0)
+			m_uintBinAmplitude[i] >>= -intLog2Ratio;
+		else
+		{
+			uintAmplitude = (uint32_t) m_uintBinAmplitude[i] << intLog2Ratio;
+			m_uintBinAmplitude[i] = (uint16_t) ((uintAmplitude > MN_FULLSCALE) ? MN_FULLSCALE : uintAmplitude);
+		}
+	}
+}
+
+/**
+ * \brief		Runs the Goertzel filters over new EEG samples.
+ *
+ * \param[in]	puintSamples	new EEG samples
+ * \param[in]	uintCount		number of samples
+ */
+void mn_process(const EEG_SAMPLE * puintSamples, uint8_t uintCount)
+{
+	int16_t intInput;
+	int32_t intS0;
+	uint8_t i;
+
+	while(uintCount--)
+	{
+		// decimation
+		m_uintDecSum += (uint8_t) (*puintSamples++ >> MN_INPUT_SHIFT);
+		if(++m_uintDecCount < MN_DECIMATION)
+			continue;
+
+		if(!m_blnOffsetValid)
+		{
+			m_intOffset = (int16_t) m_uintDecSum;
+			m_blnOffsetValid = TRUE;
+		}
+		intInput = (int16_t) m_uintDecSum - m_intOffset;
+		m_uintFrameSum += m_uintDecSum;
+		m_uintDecSum = 0;
+		m_uintDecCount = 0;
+
+		// s[n] = x[n] + coef * s[n - 1] - s[n - 2]
+		for(i = 0; i < MN_NBINS; i++)
+		{
+			intS0 = intInput - m_intS2[i] + (((int16_t) pgm_read_word(&mc_intCoefs[i]) * m_intS1[i]) >> MN_COEF_BITS);
+			m_intS2[i] = m_intS1[i];
+			m_intS1[i] = intS0;
+		}
+
+		if(++m_uintFrameCount == MN_FRAME_LENGTH)
+			mn_closeFrame();
+	}
+}
+
+/**
+ * \brief		Returns the P-P amplitude of the mains interference.
+ *
+ * \details		The amplitudes of the bins are added up, i.e. the result is the largest P-P amplitude that the
+ *				measured components can produce together.
+ *
+ * \return		P-P amplitude of the last complete frame (in ADC counts at the resolution of the EEG samples)
+ */
+EEG_SAMPLE mn_getAmplitude(void)
+{
+	uint16_t uintSum = 0;
+	uint8_t i;
+
+	for(i = 0; i < MN_NBINS; i++)
+		uintSum += m_uintBinAmplitude[i];
+
+	return (EEG_SAMPLE) ((uintSum > MN_FULLSCALE) ? MN_FULLSCALE : uintSum);
+}
+
+/**
+ * \brief		Returns the P-P amplitude of one frequency bin.
+ *
+ * \param[in]	bin		frequency bin
+ *
+ * \return		P-P amplitude of the last complete frame (in ADC counts at the resolution of the EEG samples; 0 if the
+ *				bin isn't measured)
+ */
+EEG_SAMPLE mn_getBinAmplitude(enum MN_BIN bin)
+{
+	if((uint8_t) bin >= MN_NBINS)
+		return 0;
+
+	return (EEG_SAMPLE) m_uintBinAmplitude[bin];
+}
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		mains.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Header file of module that measures the mains interference in the EEG signal.
+ */
+
+#ifndef __MAINS_H__
+#define __MAINS_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Application-Specific Definitions
+//----------------------------------------------------------------------------------------------------------
+#define MN_HARMONICS				3		///< number of harmonics of 50 Hz & 60 Hz that are measured (1 - 3; 1 = fundamentals only, 3 = up to 150 Hz & 180 Hz)
+
+//----------------------------------------------------------------------------------------------------------
+//   								Enums/Structs
+//----------------------------------------------------------------------------------------------------------
+/**
+ * Frequency bins of the detector (only the first 2 * \a MN_HARMONICS bins are measured).
+ */
+enum MN_BIN {MN_50HZ = 0,
+			 MN_60HZ,
+			 MN_100HZ,
+			 MN_120HZ,
+			 MN_150HZ,
+			 MN_180HZ
+			};
+
+//----------------------------------------------------------------------------------------------------------
+//   								Prototypes
+//----------------------------------------------------------------------------------------------------------
+void		mn_init(void);
+void		mn_reset(void);
+void		mn_scale(int8_t intLog2Ratio);
+void		mn_process(const EEG_SAMPLE * puintSamples, uint8_t uintCount);
+EEG_SAMPLE	mn_getAmplitude(void);
+EEG_SAMPLE	mn_getBinAmplitude(enum MN_BIN bin);
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * \ingroup		grp_functions
+ *
+ * \file		ring_buffer.h
+ * \since		16.10.2026
+ * \author		agent (agent@local)
+ *
+ * \brief		Macro-generated single-producer/single-consumer ring buffers.
+ *
+ * \details		RB_DEFINE(name, type, length) creates a ring buffer \c m_rb_name together with a set of
+ *				\c static \c inline access functions called \c rb_name_xxx(). One side of the buffer (e.g. an ISR)
+ *				may only call the producer functions, the other side (e.g. the background loop) may only call the
+ *				consumer functions; under this condition no interrupt locking is required:\n
+ *				- each index is an 8-bit variable (i.e. read & written atomically) that is modified by one side only\n
+ *				- one slot is always kept empty, so the amount of stored data is derived from the two indices and no
+ *				  shared counter is needed\n
+ *				- data is written/read before the index is published (enforced by a compiler memory barrier)
+ *
+ *				\a length must be a power of 2 between 2 and 256, and at most \a length - 1 elements can be stored.
+ */
+
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+//----------------------------------------------------------------------------------------------------------
+//   								Macros
+//----------------------------------------------------------------------------------------------------------
+#define RB_BARRIER()	__asm__ __volatile__ ("" ::: "memory")		///< compiler memory barrier (prevents the compiler from moving buffer accesses past an index update)
+
+/**
+ * \brief		Defines a ring buffer and its access functions.
+ *
+ * \details		Generated functions (P = producer only, C = consumer only, P/C = either side):\n
+ *				- (P/C) <tt>void rb_name_init(void)</tt>: empties the buffer (must not be called while the other side is active)\n
+ *				- (P/C) <tt>uint8_t rb_name_count(void)</tt>: number of stored elements\n
+ *				- (P/C) <tt>uint8_t rb_name_free(void)</tt>: number of elements that can still be stored\n
+ *				- (P) <tt>BOOL rb_name_put(type value)</tt>: stores one element; returns FALSE if the buffer is full\n
+ *				- (P) <tt>uint8_t rb_name_write(const type * pSrc, uint8_t n)</tt>: stores up to \a n elements; returns the number stored\n
+ *				- (C) <tt>BOOL rb_name_get(type * pValue)</tt>: removes one element; returns FALSE if the buffer is empty\n
+ *				- (C) <tt>BOOL rb_name_peek(type * pValue)</tt>: same as get, but the element stays in the buffer\n
+ *				- (C) <tt>uint8_t rb_name_read(type * pDst, uint8_t n)</tt>: removes up to \a n elements; returns the number removed\n
+ *				- (C) <tt>const type * rb_name_tail(void)</tt>: pointer to the oldest element (the following elements are contiguous up to the end of the array)\n
+ *				- (C) <tt>void rb_name_skip(uint8_t n)</tt>: removes \a n elements (\a n must not exceed the count)
+ *
+ * \param		name	name of the ring buffer
+ * \param		type	data type of the elements
+ * \param		length	length of the array (power of 2, max. 256)
+ */
+#define RB_DEFINE(name, type, length)																	\
+	typedef char rb_##name##_length_check[(((length) & ((length) - 1)) == 0 && (length) >= 2 && (length) <= 256) ? 1 : -1];	\
+																										\
+	static struct {type				data[length];														\
+				   volatile uint8_t	uintWPtr;															\
+				   volatile uint8_t	uintRPtr;															\
+				  } m_rb_##name;																		\
+																										\
+	static inline void rb_##name##_init(void)															\
+	{																									\
+		m_rb_##name.uintWPtr = m_rb_##name.uintRPtr = 0;												\
+	}																									\
+																										\
+	static inline uint8_t rb_##name##_count(void)														\
+	{																									\
+		return (uint8_t) ((uint8_t) (m_rb_##name.uintWPtr - m_rb_##name.uintRPtr) & ((length) - 1));	\
+	}																									\
+																										\
+	static inline uint8_t rb_##name##_free(void)														\
+	{																									\
+		return (uint8_t) (((length) - 1) - rb_##name##_count());										\
+	}																									\
+																										\
+	static inline BOOL rb_##name##_put(type value)														\
+	{																									\
+		uint8_t uintWPtr = m_rb_##name.uintWPtr;														\
+		uint8_t uintNext = (uint8_t) ((uintWPtr + 1) & ((length) - 1));									\
+																										\
+		if(uintNext == m_rb_##name.uintRPtr)															\
+			return FALSE;																				\
+																										\
+		m_rb_##name.data[uintWPtr] = value;																\
+		RB_BARRIER();																					\
+		m_rb_##name.uintWPtr = uintNext;																\
+																										\
+		return TRUE;																					\
+	}																									\
+																										\
+	static inline uint8_t rb_##name##_write(const type * pSrc, uint8_t n)								\
+	{																									\
+		uint8_t uintWPtr = m_rb_##name.uintWPtr;														\
+		uint8_t i;																						\
+																										\
+		if(n > rb_##name##_free())																		\
+			n = rb_##name##_free();																		\
+																										\
+		for(i = 0; i < n; i++)																			\
+		{																								\
+			m_rb_##name.data[uintWPtr] = pSrc[i];														\
+			uintWPtr = (uint8_t) ((uintWPtr + 1) & ((length) - 1));										\
+		}																								\
+																										\
+		RB_BARRIER();																					\
+		m_rb_##name.uintWPtr = uintWPtr;																\
+																										\
+		return n;																						\
+	}																									\
+																										\
+	static inline BOOL rb_##name##_peek(type * pValue)													\
+	{																									\
+		uint8_t uintRPtr = m_rb_##name.uintRPtr;														\
+																										\
+		if(uintRPtr == m_rb_##name.uintWPtr)															\
+			return FALSE;																				\
+																										\
+		RB_BARRIER();																					\
+		*pValue = m_rb_##name.data[uintRPtr];															\
+																										\
+		return TRUE;																					\
+	}																									\
+																										\
+	static inline BOOL rb_##name##_get(type * pValue)													\
+	{																									\
+		uint8_t uintRPtr = m_rb_##name.uintRPtr;														\
+																										\
+		if(uintRPtr == m_rb_##name.uintWPtr)															\
+			return FALSE;																				\
+																										\
+		RB_BARRIER();																					\
+		*pValue = m_rb_##name.data[uintRPtr];															\
+		RB_BARRIER();																					\
+		m_rb_##name.uintRPtr = (uint8_t) ((uintRPtr + 1) & ((length) - 1));							\
+																										\
+		return TRUE;																					\
+	}																									\
+																										\
+	static inline uint8_t rb_##name##_read(type * pDst, uint8_t n)										\
+	{																									\
+		uint8_t uintRPtr = m_rb_##name.uintRPtr;														\
+		uint8_t i;																						\
+																										\
+		if(n > rb_##name##_count())																		\
+			n = rb_##name##_count();																	\
+																										\
+		RB_BARRIER();																					\
+		for(i = 0; i < n; i++)																			\
+		{																								\
+			pDst[i] = m_rb_##name.data[uintRPtr];														\
+			uintRPtr = (uint8_t) ((uintRPtr + 1) & ((length) - 1));										\
+		}																								\
+																										\
+		RB_BARRIER();																					\
+		m_rb_##name.uintRPtr = uintRPtr;																\
+																										\
+		return n;																						\
+	}																									\
+																										\
+	static inline const type * rb_##name##_tail(void)													\
+	{																									\
+		RB_BARRIER();																					\
+		return &m_rb_##name.data[m_rb_##name.uintRPtr];													\
+	}																									\
+																										\
+	static inline void rb_##name##_skip(uint8_t n)														\
+	{																									\
+		RB_BARRIER();																					\
+		m_rb_##name.uintRPtr = (uint8_t) ((m_rb_##name.uintRPtr + n) & ((length) - 1));					\
+	}
+
+#endif